@@ -0,0 +1,125 @@
+#include "bench/bench.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <iostream>
+
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr int kSamples = 10;
+
+static double TimeBatchNs(std::function<void()> const& iteration, uint64_t iterations) {
+   auto start = Clock::now();
+   for(uint64_t i = 0; i < iterations; ++i) {
+      iteration();
+   }
+   return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+void Runner::run(std::string const& name, std::function<void()> const& iteration) {
+   if(!enabled(name)) {
+      return;
+   }
+
+   // grow the batch until one sample takes its share of the time budget
+   double sample_budget_ns = m_min_time_s * 1e9 / kSamples;
+   uint64_t iterations = 1;
+   while(TimeBatchNs(iteration, iterations) < sample_budget_ns) {
+      iterations *= 2;
+   }
+
+   std::vector<double> per_iteration;
+   for(int i = 0; i < kSamples; ++i) {
+      per_iteration.push_back(TimeBatchNs(iteration, iterations) / iterations);
+   }
+   std::sort(per_iteration.begin(), per_iteration.end());
+
+   Result result{
+      .name = name,
+      .iterations = iterations * kSamples,
+      .median_ns = per_iteration[kSamples / 2],
+      .min_ns = per_iteration.front(),
+   };
+   std::cerr << std::format(
+      "{:<40} {:>14.1f} ns/iter  (min {:.1f}, {} iters)\n",
+      result.name,
+      result.median_ns,
+      result.min_ns,
+      result.iterations
+   );
+   m_results.push_back(result);
+}
+
+void Runner::write_json(std::ostream& out) const {
+   out << "{\"benchmarks\": [\n";
+   for(size_t i = 0; i < m_results.size(); ++i) {
+      auto const& result = m_results[i];
+      out << std::format(
+         "{{\"name\": \"{}\", \"iterations\": {}, \"median_ns\": {:.3f}, \"min_ns\": {:.3f}}}{}\n",
+         result.name,
+         result.iterations,
+         result.median_ns,
+         result.min_ns,
+         (i + 1 < m_results.size()) ? "," : ""
+      );
+   }
+   out << "]}\n";
+}
+
+static std::string FieldValue(std::string const& line, std::string const& field) {
+   auto key = "\"" + field + "\": ";
+   auto start = line.find(key);
+   if(start == std::string::npos) {
+      return "";
+   }
+   start += key.size();
+   if(line[start] == '"') {
+      ++start;
+      return line.substr(start, line.find('"', start) - start);
+   }
+   return line.substr(start, line.find_first_of(",}", start) - start);
+}
+
+std::map<std::string, double> ReadBaseline(std::istream& in) {
+   std::map<std::string, double> baseline;
+   std::string line;
+   while(std::getline(in, line)) {
+      auto name = FieldValue(line, "name");
+      auto median = FieldValue(line, "median_ns");
+      if(!name.empty() && !median.empty()) {
+         baseline[name] = std::stod(median);
+      }
+   }
+   return baseline;
+}
+
+int CompareToBaseline(
+   std::vector<Result> const& results, std::map<std::string, double> const& baseline,
+   double threshold_percent, std::ostream& out
+) {
+   int regressions = 0;
+   for(auto const& result : results) {
+      auto it = baseline.find(result.name);
+      if(it == baseline.end()) {
+         out << std::format("{:<40} (new)\n", result.name);
+         continue;
+      }
+      double change = (result.median_ns / it->second - 1.0) * 100.0;
+      bool regressed = change > threshold_percent;
+      regressions += regressed ? 1 : 0;
+      out << std::format(
+         "{:<40} {:>14.1f} -> {:>14.1f} ns  {:+7.1f}%{}\n",
+         result.name,
+         it->second,
+         result.median_ns,
+         change,
+         regressed ? "  REGRESSION" : ""
+      );
+   }
+   return regressions;
+}
+
+} // namespace bench
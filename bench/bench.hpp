@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+inline void const* volatile g_optimization_sink = nullptr;
+
+/// @brief Keeps the compiler from optimizing away the computation of value
+template <typename T> inline void DoNotOptimize(T const& value) {
+   g_optimization_sink = &value;
+}
+
+struct Result {
+   std::string name;
+   uint64_t iterations;
+   double median_ns;
+   double min_ns;
+};
+
+class Runner {
+public:
+   /// @brief Only benchmarks whose name contains filter are run. Each
+   /// benchmark runs for roughly min_time_s seconds in total.
+   Runner(std::string filter, double min_time_s) :
+      m_filter(std::move(filter)),
+      m_min_time_s(min_time_s) {}
+
+   bool enabled(std::string const& name) const {
+      return name.find(m_filter) != std::string::npos;
+   }
+
+   /// @brief Times iteration(), which runs one iteration of the benchmark.
+   void run(std::string const& name, std::function<void()> const& iteration);
+
+   std::vector<Result> const& results() const {
+      return m_results;
+   }
+
+   /// @brief One benchmark object per line, which ReadBaseline relies on
+   void write_json(std::ostream& out) const;
+
+private:
+   std::string m_filter;
+   double m_min_time_s;
+   std::vector<Result> m_results;
+};
+
+/// @brief Reads median_ns by benchmark name from a file written by
+/// Runner::write_json
+std::map<std::string, double> ReadBaseline(std::istream& in);
+
+/// @brief Prints the change of every result against the baseline. Returns the
+/// number of benchmarks that got slower by more than threshold_percent.
+int CompareToBaseline(
+   std::vector<Result> const& results, std::map<std::string, double> const& baseline,
+   double threshold_percent, std::ostream& out
+);
+
+} // namespace bench
@@ -0,0 +1,254 @@
+#include "bench/bench.hpp"
+
+#include "calc/calc.hpp"
+#include "calc/int_format.hpp"
+#include "calc/parse.hpp"
+#include "controller.hpp"
+#include "raylib.h"
+#include "view/MonoFont.hpp"
+#include "view/view.hpp"
+
+#include <array>
+#include <charconv>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+using namespace std::literals;
+
+static std::string Repeat(std::string_view text, size_t count) {
+   std::string out;
+   out.reserve(text.size() * count);
+   for(size_t i = 0; i < count; ++i) {
+      out.append(text);
+   }
+   return out;
+}
+
+static void BenchParse(bench::Runner& runner) {
+   calc::State state;
+   auto settings = parse::ParserSettings(intbase::IntBase::kDec, state.functions);
+
+   auto run = [&](std::string const& name, std::string const& input) {
+      runner.run(name, [&] { bench::DoNotOptimize(parse::parse(settings, input)); });
+   };
+   run("parse/long_literals", Repeat("0x7fffffffffffffff 922337203685477580 0b1011011101 ", 100));
+   run("parse/many_words", Repeat("dup drop swap dup2 ", 250));
+   run("parse/super_precedence", Repeat("1+2-3*4%5/6 ", 200));
+   run("parse/floats_and_strings", Repeat("3.14159 \"abc 2.5 \"xyz ", 200));
+}
+
+static void BenchExecute(bench::Runner& runner) {
+   {
+      calc::State state;
+      auto& stack = state.committed.edit_stack();
+      for(int64_t i = 0; i < 100000; ++i) {
+         stack.push(calc::Value(i));
+      }
+      auto settings = parse::ParserSettings(intbase::IntBase::kDec, state.functions);
+      auto tokens = parse::parse(settings, "dup + swap drop");
+      runner.run("execute/deep_stack_100k", [&] {
+         state.Execute(tokens, true);
+         bench::DoNotOptimize(state.speculative.stack());
+      });
+   }
+   {
+      calc::State state;
+      auto settings = parse::ParserSettings(intbase::IntBase::kDec, state.functions);
+      auto tokens = parse::parse(settings, Repeat("1 2 + 3 * dup - ", 250));
+      runner.run("execute/long_token_stream", [&] {
+         state.Execute(tokens, true);
+         bench::DoNotOptimize(state.speculative.stack());
+      });
+   }
+}
+
+/// @brief How FormatValue formatted ints before intformat, kept to compare
+/// against. The buffer is widened from 33 chars, which could not hold a
+/// negative 64-bit value in binary.
+static std::string LegacyFormatInt(int64_t value, int base, int group) {
+   std::array<char, 66> buf{};
+   auto result = std::to_chars(buf.data(), buf.data() + buf.size(), value, base);
+   auto str = std::string(buf.data(), result.ptr);
+   if(group != 0) {
+      int skipped = 1;
+      for(int i = static_cast<int>(str.size()) - 1; i > 0; --i) {
+         if(skipped == group) {
+            str.insert(i, 1, ',');
+            skipped = 0;
+         }
+         ++skipped;
+      }
+   }
+   return str;
+}
+
+static void BenchFormat(bench::Runner& runner) {
+   Controller controller;
+   // positive, negative and small values
+   static constexpr int64_t kValues[] = {INT64_MAX, int64_t{-1234567890123}, int64_t{42}};
+   for(int64_t value : kValues) {
+      controller.state.speculative.edit_stack().push(calc::Value(value));
+   }
+
+   struct Separator {
+      SeparatorMode::Mode mode;
+      char const* name;
+      int group;
+   };
+   static constexpr Separator kSeparators[] = {
+      {SeparatorMode::Mode::kNone, "nosep", 0},
+      {SeparatorMode::Mode::kThree, "sep3", 3},
+      {SeparatorMode::Mode::kFour, "sep4", 4},
+      {SeparatorMode::Mode::kEight, "sep8", 8},
+   };
+   for(auto base : {intbase::IntBase::kDec, intbase::IntBase::kHex, intbase::IntBase::kBin}) {
+      for(auto const& separator : kSeparators) {
+         controller.sep_mode.mode = separator.mode;
+         auto name = "format/"s + intbase::as_string(base) + "/" + separator.name;
+         runner.run(name, [&] {
+            for(int i = 0; i < 3; ++i) {
+               bench::DoNotOptimize(controller.GetStackDisplayStringRadix(i, base));
+            }
+         });
+         runner.run("format_legacy/"s + intbase::as_string(base) + "/" + separator.name, [&] {
+            for(int64_t value : kValues) {
+               bench::DoNotOptimize(
+                  LegacyFormatInt(value, intbase::as_int(base), separator.group)
+               );
+            }
+         });
+      }
+   }
+
+   // the engine alone, without the string copy
+   struct Radix {
+      intformat::Radix radix;
+      char const* name;
+   };
+   static constexpr Radix kRadixes[] = {
+      {intformat::Radix::kDec, "dec"},
+      {intformat::Radix::kHex, "hex"},
+      {intformat::Radix::kOct, "oct"},
+      {intformat::Radix::kBin, "bin"},
+   };
+   for(auto const& radix : kRadixes) {
+      for(auto const& separator : kSeparators) {
+         intformat::Options options{
+            .radix = radix.radix,
+            .width = 64,
+            .group = separator.group,
+            .separator = ',',
+         };
+         runner.run("intformat/"s + radix.name + "/" + separator.name, [&] {
+            intformat::Buffer buffer;
+            for(int64_t value : kValues) {
+               bench::DoNotOptimize(intformat::Format(value, options, buffer));
+            }
+         });
+      }
+   }
+}
+
+static void BenchView(bench::Runner& runner) {
+   if(!runner.enabled("view/")) {
+      return;
+   }
+   SetTraceLogLevel(LOG_WARNING);
+   SetConfigFlags(FLAG_WINDOW_HIDDEN);
+   InitWindow(850, 450, "claculator bench");
+   SetTargetFPS(0);
+   MonoFont::get().load();
+   {
+      Controller controller;
+      for(int64_t i = 0; i < 10; ++i) {
+         controller.state.committed.edit_stack().push(calc::Value(i * 0x1111111));
+      }
+      auto& reg = controller.state.committed.edit_reg();
+      reg.AddField(Field(0, 7, "low", FieldDisplay::kNumeric));
+      reg.AddField(Field(8, 23, "mid", FieldDisplay::kNumeric));
+      controller.InsertText("1 2 + 0xff *");
+      controller.FlushPendingExecution();
+
+      View view(controller);
+      auto frame = [&] {
+         BeginDrawing();
+         view.render();
+         EndDrawing();
+      };
+      runner.run("view/render_cached", frame);
+      runner.run("view/render_uncached", [&] {
+         view.invalidate();
+         frame();
+      });
+   }
+   MonoFont::get().unload();
+   CloseWindow();
+}
+
+static void PrintUsage() {
+   std::cerr << "usage: bench [--filter <substring>] [--out <results.json>]\n"
+                "             [--baseline <results.json>] [--threshold <percent>]\n"
+                "             [--min-time <seconds>]\n";
+}
+
+int main(int argc, char** argv) {
+   std::string filter;
+   std::string out_path;
+   std::string baseline_path;
+   double threshold_percent = 10.0;
+   double min_time_s = 0.5;
+   for(int i = 1; i < argc; ++i) {
+      auto arg = std::string_view(argv[i]);
+      if(i + 1 >= argc) {
+         PrintUsage();
+         return 1;
+      }
+      if(arg == "--filter"sv) {
+         filter = argv[++i];
+      } else if(arg == "--out"sv) {
+         out_path = argv[++i];
+      } else if(arg == "--baseline"sv) {
+         baseline_path = argv[++i];
+      } else if(arg == "--threshold"sv) {
+         threshold_percent = std::strtod(argv[++i], nullptr);
+      } else if(arg == "--min-time"sv) {
+         min_time_s = std::strtod(argv[++i], nullptr);
+      } else {
+         PrintUsage();
+         return 1;
+      }
+   }
+
+   bench::Runner runner(filter, min_time_s);
+   BenchParse(runner);
+   BenchExecute(runner);
+   BenchFormat(runner);
+   BenchView(runner);
+
+   if(out_path.empty()) {
+      runner.write_json(std::cout);
+   } else {
+      std::ofstream out(out_path);
+      runner.write_json(out);
+   }
+
+   if(!baseline_path.empty()) {
+      std::ifstream baseline_file(baseline_path);
+      if(!baseline_file) {
+         std::cerr << "cannot open baseline " << baseline_path << "\n";
+         return 1;
+      }
+      auto baseline = bench::ReadBaseline(baseline_file);
+      int regressions =
+         bench::CompareToBaseline(runner.results(), baseline, threshold_percent, std::cerr);
+      if(regressions > 0) {
+         std::cerr << regressions << " benchmarks regressed by more than " << threshold_percent
+                   << "%\n";
+         return 2;
+      }
+   }
+   return 0;
+}
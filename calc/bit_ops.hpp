@@ -0,0 +1,171 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+/// Bit manipulation on the low `width` bits of a word, for width 1 to 64.
+///
+/// Counts and rotates use <bit>, which compiles to popcnt, lzcnt, tzcnt and
+/// rol where the target has them. pext and pdep use BMI2 when it is enabled,
+/// a loop over the mask bits otherwise.
+namespace bitops {
+
+constexpr uint64_t Mask(int width) {
+   return (width >= 64) ? ~uint64_t{0} : (uint64_t{1} << width) - 1;
+}
+
+/// @brief The low width bits as a signed value
+constexpr int64_t SignExtend(uint64_t bits, int width) {
+   int unused = 64 - width;
+   return static_cast<int64_t>(bits << unused) >> unused;
+}
+
+/// @brief Shifts in zeros, counts of width or more give 0
+constexpr uint64_t ShiftLeft(uint64_t bits, uint64_t count, int width) {
+   return (count >= static_cast<uint64_t>(width)) ? 0 : (bits << count) & Mask(width);
+}
+
+/// @brief Shifts in zeros, counts of width or more give 0
+constexpr uint64_t ShiftRight(uint64_t bits, uint64_t count, int width) {
+   return (count >= static_cast<uint64_t>(width)) ? 0 : (bits & Mask(width)) >> count;
+}
+
+/// @brief Shifts in copies of the sign bit
+constexpr uint64_t ShiftRightArithmetic(uint64_t bits, uint64_t count, int width) {
+   uint64_t capped = (count >= static_cast<uint64_t>(width)) ? width - 1 : count;
+   return static_cast<uint64_t>(SignExtend(bits, width) >> capped) & Mask(width);
+}
+
+/// @brief Any count, taken modulo the width
+constexpr uint64_t RotateLeft(uint64_t bits, int64_t count, int width) {
+   bits &= Mask(width);
+   if(width == 64) {
+      return std::rotl(bits, static_cast<int>(count % 64));
+   }
+   auto n = static_cast<int>(((count % width) + width) % width);
+   if(n == 0) {
+      return bits;
+   }
+   return ((bits << n) | (bits >> (width - n))) & Mask(width);
+}
+
+/// @brief Any count, taken modulo the width
+constexpr uint64_t RotateRight(uint64_t bits, int64_t count, int width) {
+   return RotateLeft(bits, -(count % width), width);
+}
+
+constexpr int PopCount(uint64_t bits, int width) {
+   return std::popcount(bits & Mask(width));
+}
+
+/// @brief Leading zeros within the width, width for 0
+constexpr int CountLeadingZeros(uint64_t bits, int width) {
+   return std::countl_zero(bits & Mask(width)) - (64 - width);
+}
+
+/// @brief Width for 0
+constexpr int CountTrailingZeros(uint64_t bits, int width) {
+   int count = std::countr_zero(bits & Mask(width));
+   return (count > width) ? width : count;
+}
+
+constexpr uint64_t ByteSwap64(uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+   return __builtin_bswap64(bits);
+#else
+   bits = ((bits & 0x00ff00ff00ff00ff) << 8) | ((bits >> 8) & 0x00ff00ff00ff00ff);
+   bits = ((bits & 0x0000ffff0000ffff) << 16) | ((bits >> 16) & 0x0000ffff0000ffff);
+   return (bits << 32) | (bits >> 32);
+#endif
+}
+
+/// @brief Reverses the whole bytes of the width, a width of 8 or less is
+/// unchanged
+constexpr uint64_t ByteSwap(uint64_t bits, int width) {
+   int bytes = width / 8;
+   if(bytes <= 1) {
+      return bits & Mask(width);
+   }
+   return ByteSwap64(bits) >> (64 - bytes * 8);
+}
+
+constexpr uint64_t BitReverse64(uint64_t bits) {
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_bitreverse64)
+   return __builtin_bitreverse64(bits);
+#endif
+#endif
+   bits = ((bits & 0x5555555555555555) << 1) | ((bits >> 1) & 0x5555555555555555);
+   bits = ((bits & 0x3333333333333333) << 2) | ((bits >> 2) & 0x3333333333333333);
+   bits = ((bits & 0x0f0f0f0f0f0f0f0f) << 4) | ((bits >> 4) & 0x0f0f0f0f0f0f0f0f);
+   return ByteSwap64(bits);
+}
+
+/// @brief Reverses the order of the low width bits
+constexpr uint64_t BitReverse(uint64_t bits, int width) {
+   return BitReverse64(bits) >> (64 - width);
+}
+
+/// @brief Gathers the bits selected by mask into the low bits
+inline uint64_t ParallelExtract(uint64_t bits, uint64_t mask) {
+#if defined(__BMI2__)
+   return _pext_u64(bits, mask);
+#else
+   uint64_t result = 0;
+   for(uint64_t out = 1; mask != 0; mask &= mask - 1, out <<= 1) {
+      if((bits & mask & -mask) != 0) {
+         result |= out;
+      }
+   }
+   return result;
+#endif
+}
+
+/// @brief Scatters the low bits to the positions selected by mask
+inline uint64_t ParallelDeposit(uint64_t bits, uint64_t mask) {
+#if defined(__BMI2__)
+   return _pdep_u64(bits, mask);
+#else
+   uint64_t result = 0;
+   for(uint64_t in = 1; mask != 0; mask &= mask - 1, in <<= 1) {
+      if((bits & in) != 0) {
+         result |= mask & -mask;
+      }
+   }
+   return result;
+#endif
+}
+
+inline constexpr uint64_t kEvenBits = 0x5555555555555555;
+
+/// @brief Interleaves the low 32 bits of x into the even bits and of y into
+/// the odd bits
+inline uint64_t MortonEncode(uint64_t x, uint64_t y) {
+   return ParallelDeposit(x, kEvenBits) | ParallelDeposit(y, kEvenBits << 1);
+}
+
+/// @brief The inverse of MortonEncode, x from the even bits
+inline void MortonDecode(uint64_t code, uint64_t& x, uint64_t& y) {
+   x = ParallelExtract(code, kEvenBits);
+   y = ParallelExtract(code, kEvenBits << 1);
+}
+
+constexpr uint64_t GrayEncode(uint64_t bits, int width) {
+   bits &= Mask(width);
+   return bits ^ (bits >> 1);
+}
+
+constexpr uint64_t GrayDecode(uint64_t gray, int width) {
+   gray &= Mask(width);
+   // every bit is the xor of the bits above it, a prefix xor in six steps
+   for(int shift = 1; shift < 64; shift <<= 1) {
+      gray ^= gray >> shift;
+   }
+   return gray;
+}
+
+} // namespace bitops
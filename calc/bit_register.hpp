@@ -1,5 +1,9 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -21,17 +25,58 @@ public:
    std::string name;
    FieldDisplay display;
 
-   std::string GetDisplay(int64_t value) const {
+   int64_t GetValue(int64_t value) const {
       int64_t mask =
          (1ul << ((int64_t)lastbit - (int64_t)firstbit + 1ul)) - 1ul;
-      int64_t field_value = ((value >> (int64_t)firstbit) & mask);
-      return std::to_string(field_value);
+      return ((value >> (int64_t)firstbit) & mask);
+   }
+
+   std::string GetDisplay(int64_t value) const {
+      return std::to_string(GetValue(value));
+   }
+
+   bool operator==(Field const&) const = default;
+
+   /// @brief Writes "name=value" into out, reusing its capacity
+   void GetLabel(int64_t value, std::string& out) const {
+      std::array<char, 24> buf{};
+      auto result = std::to_chars(buf.data(), buf.data() + buf.size(), GetValue(value));
+      out.assign(name);
+      out.push_back('=');
+      out.append(buf.data(), result.ptr);
    }
 };
 
 class RegisterDisplay {
 public:
-   constexpr RegisterDisplay(std::vector<Field> _fields) :
-      fields(std::move(_fields)) {}
+   RegisterDisplay(std::vector<Field> _fields) :
+      fields(std::move(_fields)),
+      revision(NextRevision()) {}
    std::vector<Field> fields;
-};
\ No newline at end of file
+
+   /// @brief Changes whenever the field list changes. Revisions are unique
+   /// across all displays, so copies of a display that were changed
+   /// differently never share one.
+   uint64_t revision;
+
+   void AddField(Field field) {
+      fields.push_back(std::move(field));
+      revision = NextRevision();
+   }
+
+   void ClearFields() {
+      fields.clear();
+      revision = NextRevision();
+   }
+
+   void SetFields(std::vector<Field> _fields) {
+      fields = std::move(_fields);
+      revision = NextRevision();
+   }
+
+private:
+   static uint64_t NextRevision() {
+      static std::atomic<uint64_t> next{1};
+      return next.fetch_add(1, std::memory_order_relaxed);
+   }
+};
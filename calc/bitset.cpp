@@ -0,0 +1,254 @@
+#include "calc/bitset.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+namespace bitset {
+
+namespace {
+
+constexpr uint64_t kAllOnes = ~uint64_t{0};
+
+/// @brief Sets bits first to last, words must already hold last
+void SetRange(calc::BitWords& words, size_t first, size_t last) {
+   size_t first_word = first / 64;
+   size_t last_word = last / 64;
+   uint64_t first_mask = kAllOnes << (first % 64);
+   uint64_t last_mask = kAllOnes >> (63 - last % 64);
+   if(first_word == last_word) {
+      words[first_word] |= first_mask & last_mask;
+      return;
+   }
+   words[first_word] |= first_mask;
+   std::fill(words.begin() + first_word + 1, words.begin() + last_word, kAllOnes);
+   words[last_word] |= last_mask;
+}
+
+/// @brief The first bit from `from` up that equals value, the bit count of
+/// the words if there is none
+size_t NextBit(std::span<uint64_t const> words, size_t from, bool value) {
+   size_t end = words.size() * 64;
+   if(from >= end) {
+      return end;
+   }
+   uint64_t invert = value ? 0 : kAllOnes;
+   size_t i = from / 64;
+   uint64_t word = (words[i] ^ invert) & (kAllOnes << (from % 64));
+   while(word == 0) {
+      if(++i == words.size()) {
+         return end;
+      }
+      word = words[i] ^ invert;
+   }
+   return i * 64 + static_cast<size_t>(std::countr_zero(word));
+}
+
+bool ParseIndex(std::string_view& text, size_t& index) {
+   auto result = std::from_chars(text.data(), text.data() + text.size(), index);
+   if(result.ec != std::errc()) {
+      return false;
+   }
+   text.remove_prefix(static_cast<size_t>(result.ptr - text.data()));
+   return true;
+}
+
+template <SetOp op> uint64_t CombineWord(uint64_t a, uint64_t b) {
+   if constexpr(op == SetOp::kAnd) {
+      return a & b;
+   } else if constexpr(op == SetOp::kOr) {
+      return a | b;
+   } else if constexpr(op == SetOp::kXor) {
+      return a ^ b;
+   } else {
+      return a & ~b;
+   }
+}
+
+#if defined(__SSE2__)
+template <SetOp op> __m128i CombineBlock(__m128i a, __m128i b) {
+   if constexpr(op == SetOp::kAnd) {
+      return _mm_and_si128(a, b);
+   } else if constexpr(op == SetOp::kOr) {
+      return _mm_or_si128(a, b);
+   } else if constexpr(op == SetOp::kXor) {
+      return _mm_xor_si128(a, b);
+   } else {
+      // andnot complements its first operand
+      return _mm_andnot_si128(b, a);
+   }
+}
+#endif
+
+template <SetOp op>
+calc::BitWords CombineAll(std::span<uint64_t const> a, std::span<uint64_t const> b) {
+   // words past the end of the shorter set are zero, so and stops at the
+   // shorter one and and-not at the end of a
+   size_t size = std::max(a.size(), b.size());
+   if constexpr(op == SetOp::kAnd) {
+      size = std::min(a.size(), b.size());
+   } else if constexpr(op == SetOp::kAndNot) {
+      size = a.size();
+   }
+   calc::BitWords out(size);
+   size_t common = std::min({a.size(), b.size(), size});
+   size_t i = 0;
+#if defined(__SSE2__)
+   for(; i + 2 <= common; i += 2) {
+      __m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a.data() + i));
+      __m128i y = _mm_loadu_si128(reinterpret_cast<__m128i const*>(b.data() + i));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out.data() + i), CombineBlock<op>(x, y));
+   }
+#endif
+   for(; i < common; ++i) {
+      out[i] = CombineWord<op>(a[i], b[i]);
+   }
+   for(; i < size; ++i) {
+      out[i] = CombineWord<op>((i < a.size()) ? a[i] : 0, (i < b.size()) ? b[i] : 0);
+   }
+   Trim(out);
+   return out;
+}
+
+} // namespace
+
+void Trim(calc::BitWords& words) {
+   while(!words.empty() && (words.back() == 0)) {
+      words.pop_back();
+   }
+}
+
+bool ParseRangeList(std::string_view text, calc::BitWords& out) {
+   out.clear();
+   if(text.empty()) {
+      return true;
+   }
+   while(true) {
+      size_t first = 0;
+      if(!ParseIndex(text, first)) {
+         return false;
+      }
+      size_t last = first;
+      if(text.starts_with('-')) {
+         text.remove_prefix(1);
+         if(!ParseIndex(text, last)) {
+            return false;
+         }
+      }
+      if((last < first) || (last >= kMaxBits)) {
+         return false;
+      }
+      // the word of the highest bit so far is the last one, so the result
+      // needs no trimming
+      if(out.size() <= last / 64) {
+         out.resize(last / 64 + 1);
+      }
+      SetRange(out, first, last);
+      if(text.empty()) {
+         return true;
+      }
+      if(!text.starts_with(',')) {
+         return false;
+      }
+      text.remove_prefix(1);
+   }
+}
+
+std::vector<Run> Runs(std::span<uint64_t const> words, size_t max_runs) {
+   std::vector<Run> runs;
+   size_t end = words.size() * 64;
+   size_t bit = NextBit(words, 0, true);
+   while((bit < end) && (runs.size() < max_runs)) {
+      size_t clear = NextBit(words, bit, false);
+      runs.push_back(Run{bit, clear - 1});
+      bit = NextBit(words, clear, true);
+   }
+   return runs;
+}
+
+size_t RunCount(std::span<uint64_t const> words) {
+   size_t count = 0;
+   uint64_t carry = 0;
+   for(uint64_t word : words) {
+      // a run starts at each set bit whose lower neighbour is clear
+      count += static_cast<size_t>(std::popcount(word & ~((word << 1) | carry)));
+      carry = word >> 63;
+   }
+   return count;
+}
+
+std::string FormatRangeList(std::span<uint64_t const> words, size_t max_runs) {
+   auto runs = Runs(words, max_runs);
+   std::string text;
+   for(auto const& run : runs) {
+      if(!text.empty()) {
+         text.push_back(',');
+      }
+      text.append(std::to_string(run.first));
+      if(run.last != run.first) {
+         text.push_back('-');
+         text.append(std::to_string(run.last));
+      }
+   }
+   if(!runs.empty() && (NextBit(words, runs.back().last + 1, true) < words.size() * 64)) {
+      text.append(",...");
+   }
+   return text;
+}
+
+calc::BitWords FromInt(uint64_t bits) {
+   calc::BitWords words;
+   if(bits != 0) {
+      words.push_back(bits);
+   }
+   return words;
+}
+
+calc::BitWords Combine(SetOp op, std::span<uint64_t const> a, std::span<uint64_t const> b) {
+   switch(op) {
+   case SetOp::kAnd:
+      return CombineAll<SetOp::kAnd>(a, b);
+   case SetOp::kOr:
+      return CombineAll<SetOp::kOr>(a, b);
+   case SetOp::kXor:
+      return CombineAll<SetOp::kXor>(a, b);
+   case SetOp::kAndNot:
+      return CombineAll<SetOp::kAndNot>(a, b);
+   }
+   return {};
+}
+
+size_t PopCount(std::span<uint64_t const> words) {
+   size_t count = 0;
+   size_t i = 0;
+#if defined(__SSSE3__) && !defined(__POPCNT__)
+   // bits per nibble, looked up sixteen bytes at a time and summed with psadbw
+   __m128i const lookup = _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+   __m128i const low_nibbles = _mm_set1_epi8(0x0f);
+   __m128i totals = _mm_setzero_si128();
+   for(; i + 2 <= words.size(); i += 2) {
+      __m128i block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(words.data() + i));
+      __m128i low = _mm_and_si128(block, low_nibbles);
+      __m128i high = _mm_and_si128(_mm_srli_epi16(block, 4), low_nibbles);
+      __m128i counts =
+         _mm_add_epi8(_mm_shuffle_epi8(lookup, low), _mm_shuffle_epi8(lookup, high));
+      totals = _mm_add_epi64(totals, _mm_sad_epu8(counts, _mm_setzero_si128()));
+   }
+   count = static_cast<size_t>(
+      _mm_cvtsi128_si64(totals) + _mm_cvtsi128_si64(_mm_unpackhi_epi64(totals, totals))
+   );
+#endif
+   for(; i < words.size(); ++i) {
+      count += static_cast<size_t>(std::popcount(words[i]));
+   }
+   return count;
+}
+
+} // namespace bitset
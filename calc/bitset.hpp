@@ -0,0 +1,59 @@
+#pragma once
+
+#include "calc/value.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Sets of bit indices wider than an int, e.g. CPU affinity or interrupt
+/// masks, stored as calc::BitWords.
+///
+/// They are written as range lists like the Linux cpulist format: `0-3,8-11,64`
+/// is bits 0 to 3, 8 to 11 and 64, and the empty list is the empty set. Set
+/// operations run over two words at a time with SSE2. Popcount uses the
+/// popcnt instruction where the target has it, otherwise SSSE3 nibble
+/// lookups that count sixteen bytes at a time.
+namespace bitset {
+
+/// @brief Bits are 0 to kMaxBits - 1, so a bitset is at most 8 KiB
+inline constexpr size_t kMaxBits = size_t{1} << 16;
+
+/// @brief Set bits first to last, both inclusive
+struct Run {
+   size_t first;
+   size_t last;
+};
+
+/// @brief Drops zero words from the end
+void Trim(calc::BitWords& words);
+
+/// @brief Decimal indices in any order, overlapping ranges are merged. False
+/// for malformed lists, ranges that end before they start and bits from
+/// kMaxBits up.
+bool ParseRangeList(std::string_view text, calc::BitWords& out);
+
+/// @brief The shortest range list, ascending. Only the first max_runs runs
+/// are written, followed by ",..." if there are more.
+std::string FormatRangeList(std::span<uint64_t const> words, size_t max_runs = SIZE_MAX);
+
+/// @brief The runs of set bits in ascending order, at most max_runs of them
+std::vector<Run> Runs(std::span<uint64_t const> words, size_t max_runs = SIZE_MAX);
+
+/// @brief The number of runs of set bits, without listing them
+size_t RunCount(std::span<uint64_t const> words);
+
+/// @brief The set bits of an int, already masked to its width
+calc::BitWords FromInt(uint64_t bits);
+
+enum class SetOp { kAnd, kOr, kXor, kAndNot };
+
+/// @brief a op b, kAndNot is a & ~b
+calc::BitWords Combine(SetOp op, std::span<uint64_t const> a, std::span<uint64_t const> b);
+
+size_t PopCount(std::span<uint64_t const> words);
+
+} // namespace bitset
@@ -0,0 +1,845 @@
+#include "calc/builtins.hpp"
+#include "calc/bit_ops.hpp"
+#include "calc/bitset.hpp"
+#include "calc/byte_codec.hpp"
+#include "calc/checksum.hpp"
+#include "calc/context.hpp"
+#include "calc/gf2.hpp"
+#include "calc/lanes.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <optional>
+#include <string>
+
+namespace calc {
+
+using ExecutionResult = Function::ExecutionResult;
+
+namespace {
+
+enum class Arithmetic { kAdd, kSubtract, kMultiply, kModulo, kDivide };
+
+using BinaryKernel = ExecutionResult (*)(Value const& a, Value const& b);
+
+/// @brief Kernels for one operator, indexed by TypePair
+using BinaryKernels = std::array<BinaryKernel, Value::kTypeCount * Value::kTypeCount>;
+
+constexpr size_t TypePair(Value::Type a, Value::Type b) {
+   return static_cast<size_t>(a) * Value::kTypeCount + static_cast<size_t>(b);
+}
+
+/// @brief Longest string that repetition makes
+constexpr size_t kMaxRepeatBytes = size_t{1} << 28;
+
+template <Arithmetic op> ExecutionResult IntKernel(Value const& a, Value const& b) {
+   int64_t x = a.as_int();
+   int64_t y = b.as_int();
+   // wraps on overflow
+   auto ux = static_cast<uint64_t>(x);
+   auto uy = static_cast<uint64_t>(y);
+   if constexpr(op == Arithmetic::kAdd) {
+      return ExecutionResult::make_success({Value(static_cast<int64_t>(ux + uy))});
+   } else if constexpr(op == Arithmetic::kSubtract) {
+      return ExecutionResult::make_success({Value(static_cast<int64_t>(ux - uy))});
+   } else if constexpr(op == Arithmetic::kMultiply) {
+      return ExecutionResult::make_success({Value(static_cast<int64_t>(ux * uy))});
+   } else {
+      if(y == 0) {
+         return ExecutionResult::make_error("div by zero");
+      }
+      if((x == std::numeric_limits<int64_t>::min()) && (y == -1)) {
+         return ExecutionResult::make_error("overflow");
+      }
+      return ExecutionResult::make_success({Value(op == Arithmetic::kDivide ? x / y : x % y)});
+   }
+}
+
+template <Value::Type type> double AsDouble(Value const& value) {
+   if constexpr(type == Value::Type::kInt) {
+      return static_cast<double>(value.as_int());
+   } else {
+      return value.as_double();
+   }
+}
+
+/// @brief Any mix of ints and doubles, the int is converted
+template <Arithmetic op, Value::Type lhs, Value::Type rhs>
+ExecutionResult DoubleKernel(Value const& a, Value const& b) {
+   double x = AsDouble<lhs>(a);
+   double y = AsDouble<rhs>(b);
+   double result = 0.0;
+   if constexpr(op == Arithmetic::kAdd) {
+      result = x + y;
+   } else if constexpr(op == Arithmetic::kSubtract) {
+      result = x - y;
+   } else if constexpr(op == Arithmetic::kMultiply) {
+      result = x * y;
+   } else if constexpr(op == Arithmetic::kModulo) {
+      result = std::fmod(x, y);
+   } else {
+      result = x / y;
+   }
+   return ExecutionResult::make_success({Value(result)});
+}
+
+ExecutionResult ConcatenateKernel(Value const& a, Value const& b) {
+   auto x = a.as_string_view();
+   auto y = b.as_string_view();
+   std::string result;
+   result.reserve(x.size() + y.size());
+   result.append(x).append(y);
+   return ExecutionResult::make_success({Value(std::move(result))});
+}
+
+/// @brief `"ab 3 *` or `3 "ab *`
+template <Value::Type lhs> ExecutionResult RepeatKernel(Value const& a, Value const& b) {
+   auto text = (lhs == Value::Type::kString) ? a.as_string_view() : b.as_string_view();
+   int64_t count = (lhs == Value::Type::kString) ? b.as_int() : a.as_int();
+   if(count < 0) {
+      return ExecutionResult::make_error("negative repeat count");
+   }
+   // the length check below does not bound the count of an empty text
+   if(text.empty()) {
+      return ExecutionResult::make_success({Value(std::string())});
+   }
+   if(static_cast<uint64_t>(count) > kMaxRepeatBytes / text.size()) {
+      return ExecutionResult::make_error("string too long");
+   }
+   std::string result;
+   result.reserve(text.size() * static_cast<size_t>(count));
+   for(int64_t i = 0; i < count; ++i) {
+      result.append(text);
+   }
+   return ExecutionResult::make_success({Value(std::move(result))});
+}
+
+ExecutionResult ConcatenateBytesKernel(Value const& a, Value const& b) {
+   auto x = a.as_bytes();
+   auto y = b.as_bytes();
+   Bytes result;
+   result.reserve(x.size() + y.size());
+   result.insert(result.end(), x.begin(), x.end());
+   result.insert(result.end(), y.begin(), y.end());
+   return ExecutionResult::make_success({Value(std::move(result))});
+}
+
+ExecutionResult UnsupportedKernel(Value const& a, Value const& b) {
+   return ExecutionResult::make_error("unsupported argument types");
+}
+
+template <Arithmetic op> constexpr BinaryKernels MakeKernels() {
+   using enum Value::Type;
+   BinaryKernels kernels{};
+   kernels.fill(&UnsupportedKernel);
+   kernels[TypePair(kInt, kInt)] = &IntKernel<op>;
+   kernels[TypePair(kInt, kDouble)] = &DoubleKernel<op, kInt, kDouble>;
+   kernels[TypePair(kDouble, kInt)] = &DoubleKernel<op, kDouble, kInt>;
+   kernels[TypePair(kDouble, kDouble)] = &DoubleKernel<op, kDouble, kDouble>;
+   if constexpr(op == Arithmetic::kAdd) {
+      kernels[TypePair(kString, kString)] = &ConcatenateKernel;
+      kernels[TypePair(kBytes, kBytes)] = &ConcatenateBytesKernel;
+   } else if constexpr(op == Arithmetic::kMultiply) {
+      kernels[TypePair(kString, kInt)] = &RepeatKernel<kString>;
+      kernels[TypePair(kInt, kString)] = &RepeatKernel<kInt>;
+   }
+   return kernels;
+}
+
+/// @brief Picks the kernel for the argument types with one table load
+template <Arithmetic op> ExecutionResult BinaryOp(std::span<Value> input) {
+   static constexpr BinaryKernels kKernels = MakeKernels<op>();
+   return kKernels[TypePair(input[0].type(), input[1].type())](input[0], input[1]);
+}
+
+ExecutionResult AddWord(Context& context, std::span<Value> input) {
+   return BinaryOp<Arithmetic::kAdd>(input);
+}
+
+ExecutionResult SubtractWord(Context& context, std::span<Value> input) {
+   return BinaryOp<Arithmetic::kSubtract>(input);
+}
+
+ExecutionResult MultiplyWord(Context& context, std::span<Value> input) {
+   return BinaryOp<Arithmetic::kMultiply>(input);
+}
+
+ExecutionResult ModuloWord(Context& context, std::span<Value> input) {
+   return BinaryOp<Arithmetic::kModulo>(input);
+}
+
+ExecutionResult DivideWord(Context& context, std::span<Value> input) {
+   return BinaryOp<Arithmetic::kDivide>(input);
+}
+
+ExecutionResult DropWord(Context& context, std::span<Value> input) {
+   return ExecutionResult::make_success();
+}
+
+ExecutionResult DupWord(Context& context, std::span<Value> input) {
+   return ExecutionResult::make_success({input[0], input[0]});
+}
+
+ExecutionResult Dup2Word(Context& context, std::span<Value> input) {
+   return ExecutionResult::make_success({input[0], input[1], input[0], input[1]});
+}
+
+ExecutionResult SwapWord(Context& context, std::span<Value> input) {
+   return ExecutionResult::make_success({input[1], input[0]});
+}
+
+ExecutionResult FieldWord(Context& context, std::span<Value> input) {
+   if((input[0].type() != Value::Type::kInt) || (input[1].type() != Value::Type::kInt) ||
+      (input[2].type() != Value::Type::kString)) {
+      return ExecutionResult::make_error("require (int int string)");
+   }
+
+   for(auto const& field : context.reg().fields) {
+      if(field.name == input[2].as_string()) {
+         // an identical field already exists
+         return ExecutionResult::make_success();
+      }
+   }
+
+   context.edit_reg().AddField(
+      Field(input[0].as_int(), input[1].as_int(), input[2].as_string(), FieldDisplay::kNumeric)
+   );
+   return ExecutionResult::make_success();
+}
+
+ExecutionResult ClearFieldsWord(Context& context, std::span<Value> input) {
+   if(!context.reg().fields.empty()) {
+      context.edit_reg().ClearFields();
+   }
+   return ExecutionResult::make_success();
+}
+
+/// @brief `value "name store`
+ExecutionResult StoreWord(Context& context, std::span<Value> input) {
+   if(input[1].type() != Value::Type::kString) {
+      return ExecutionResult::make_error("require a string name");
+   }
+   context.edit_variables().insert_or_assign(input[1].as_string(), std::move(input[0]));
+   return ExecutionResult::make_success();
+}
+
+/// @brief `"name load`
+ExecutionResult LoadWord(Context& context, std::span<Value> input) {
+   if(input[0].type() != Value::Type::kString) {
+      return ExecutionResult::make_error("require a string name");
+   }
+   auto const& variables = context.variables();
+   auto it = variables.find(input[0].as_string());
+   if(it == variables.end()) {
+      return ExecutionResult::make_error(std::format("no variable {}", input[0].as_string()));
+   }
+   return ExecutionResult::make_success({it->second});
+}
+
+bool IsData(Value const& value) {
+   return (value.type() == Value::Type::kString) || (value.type() == Value::Type::kBytes);
+}
+
+/// @brief `"text bytes`, the string's bytes as a buffer
+ExecutionResult BytesWord(Context& context, std::span<Value> input) {
+   if(!IsData(input[0])) {
+      return ExecutionResult::make_error("require bytes or a string");
+   }
+   if(input[0].type() == Value::Type::kBytes) {
+      return ExecutionResult::make_success({std::move(input[0])});
+   }
+   auto payload = input[0].payload();
+   return ExecutionResult::make_success({Value(Bytes(payload.begin(), payload.end()))});
+}
+
+/// @brief The buffer's bytes as a string, or a bitset's range list
+ExecutionResult StrWord(Context& context, std::span<Value> input) {
+   if(input[0].type() == Value::Type::kBitset) {
+      auto list = bitset::FormatRangeList(input[0].as_bitset());
+      return ExecutionResult::make_success({Value(std::move(list))});
+   }
+   if(!IsData(input[0])) {
+      return ExecutionResult::make_error("require bytes, a string or a bitset");
+   }
+   if(input[0].type() == Value::Type::kString) {
+      return ExecutionResult::make_success({std::move(input[0])});
+   }
+   auto payload = input[0].payload();
+   return ExecutionResult::make_success({Value(std::string(payload.begin(), payload.end()))});
+}
+
+ExecutionResult LengthWord(Context& context, std::span<Value> input) {
+   if(!IsData(input[0])) {
+      return ExecutionResult::make_error("require bytes or a string");
+   }
+   return ExecutionResult::make_success({Value(static_cast<int64_t>(input[0].payload().size()))});
+}
+
+ExecutionResult ToHexWord(Context& context, std::span<Value> input) {
+   if(!IsData(input[0])) {
+      return ExecutionResult::make_error("require bytes or a string");
+   }
+   return ExecutionResult::make_success({Value(bytecodec::EncodeHex(input[0].payload()))});
+}
+
+ExecutionResult FromHexWord(Context& context, std::span<Value> input) {
+   if(input[0].type() != Value::Type::kString) {
+      return ExecutionResult::make_error("require a string");
+   }
+   Bytes bytes;
+   if(!bytecodec::DecodeHex(input[0].as_string_view(), bytes)) {
+      return ExecutionResult::make_error("invalid hex");
+   }
+   return ExecutionResult::make_success({Value(std::move(bytes))});
+}
+
+ExecutionResult ToBase64Word(Context& context, std::span<Value> input) {
+   if(!IsData(input[0])) {
+      return ExecutionResult::make_error("require bytes or a string");
+   }
+   return ExecutionResult::make_success({Value(bytecodec::EncodeBase64(input[0].payload()))});
+}
+
+ExecutionResult FromBase64Word(Context& context, std::span<Value> input) {
+   if(input[0].type() != Value::Type::kString) {
+      return ExecutionResult::make_error("require a string");
+   }
+   Bytes bytes;
+   if(!bytecodec::DecodeBase64(input[0].as_string_view(), bytes)) {
+      return ExecutionResult::make_error("invalid base64");
+   }
+   return ExecutionResult::make_success({Value(std::move(bytes))});
+}
+
+/// @brief A checksum of bytes or a string, as the int with its bits
+template <typename Digest> ExecutionResult ChecksumWord(std::span<Value> input, Digest digest) {
+   if(!IsData(input[0])) {
+      return ExecutionResult::make_error("require bytes or a string");
+   }
+   return ExecutionResult::make_success({Value(static_cast<int64_t>(digest(input[0].payload())))});
+}
+
+ExecutionResult Crc8Word(Context& context, std::span<Value> input) {
+   return ChecksumWord(input, [](auto data) { return checksum::Crc(checksum::kCrc8, data); });
+}
+
+ExecutionResult Crc16Word(Context& context, std::span<Value> input) {
+   return ChecksumWord(input, [](auto data) { return checksum::Crc(checksum::kCrc16, data); });
+}
+
+ExecutionResult Crc32Word(Context& context, std::span<Value> input) {
+   return ChecksumWord(input, [](auto data) { return checksum::Crc(checksum::kCrc32, data); });
+}
+
+ExecutionResult Crc32cWord(Context& context, std::span<Value> input) {
+   return ChecksumWord(input, [](auto data) { return checksum::Crc(checksum::kCrc32c, data); });
+}
+
+/// @brief `data width poly init xorout crc`, the poly is not reflected
+ExecutionResult CustomCrc(std::span<Value> input, bool reflect) {
+   if(!IsData(input[0])) {
+      return ExecutionResult::make_error("require bytes or a string");
+   }
+   for(auto const& arg : input.subspan(1)) {
+      if(arg.type() != Value::Type::kInt) {
+         return ExecutionResult::make_error("require (data int int int int)");
+      }
+   }
+   int64_t width = input[1].as_int();
+   if((width < 1) || (width > 64)) {
+      return ExecutionResult::make_error("width must be 1 to 64");
+   }
+   checksum::CrcModel model{
+      .width = static_cast<int>(width),
+      .poly = static_cast<uint64_t>(input[2].as_int()),
+      .init = static_cast<uint64_t>(input[3].as_int()),
+      .reflect = reflect,
+      .xorout = static_cast<uint64_t>(input[4].as_int()),
+   };
+   return ExecutionResult::make_success(
+      {Value(static_cast<int64_t>(checksum::Crc(model, input[0].payload())))}
+   );
+}
+
+ExecutionResult CrcWord(Context& context, std::span<Value> input) {
+   return CustomCrc(input, false);
+}
+
+ExecutionResult CrcReflectedWord(Context& context, std::span<Value> input) {
+   return CustomCrc(input, true);
+}
+
+ExecutionResult Fnv1aWord(Context& context, std::span<Value> input) {
+   return ChecksumWord(input, &checksum::Fnv1a64);
+}
+
+ExecutionResult XxHash64Word(Context& context, std::span<Value> input) {
+   return ChecksumWord(input, [](auto data) { return checksum::XxHash64(data); });
+}
+
+bool AllInts(std::span<Value const> input) {
+   return std::ranges::all_of(input, [](Value const& arg) {
+      return arg.type() == Value::Type::kInt;
+   });
+}
+
+/// @brief op(bits, width) on the low bits of an int at the context's width,
+/// the result is sign extended from it
+template <typename Op>
+ExecutionResult UnaryBits(Context const& context, std::span<Value> input, Op op) {
+   if(!AllInts(input)) {
+      return ExecutionResult::make_error("require an int");
+   }
+   int width = context.int_width();
+   uint64_t bits = static_cast<uint64_t>(input[0].as_int()) & bitops::Mask(width);
+   return ExecutionResult::make_success({Value(bitops::SignExtend(op(bits, width), width))});
+}
+
+/// @brief op(bits, width) on an int, giving a count rather than bits
+template <typename Op>
+ExecutionResult CountBits(Context const& context, std::span<Value> input, Op op) {
+   if(!AllInts(input)) {
+      return ExecutionResult::make_error("require an int");
+   }
+   int width = context.int_width();
+   return ExecutionResult::make_success(
+      {Value(static_cast<int64_t>(op(static_cast<uint64_t>(input[0].as_int()), width)))}
+   );
+}
+
+/// @brief op(a, b, width) on the low bits of two ints, see UnaryBits
+template <typename Op>
+ExecutionResult BinaryBits(Context const& context, std::span<Value> input, Op op) {
+   if(!AllInts(input)) {
+      return ExecutionResult::make_error("require (int int)");
+   }
+   int width = context.int_width();
+   uint64_t a = static_cast<uint64_t>(input[0].as_int()) & bitops::Mask(width);
+   uint64_t b = static_cast<uint64_t>(input[1].as_int()) & bitops::Mask(width);
+   return ExecutionResult::make_success({Value(bitops::SignExtend(op(a, b, width), width))});
+}
+
+/// @brief `bits count op`, the count is not masked to the width
+template <typename Op>
+ExecutionResult Shift(Context const& context, std::span<Value> input, Op op) {
+   if(!AllInts(input)) {
+      return ExecutionResult::make_error("require (int int)");
+   }
+   if(input[1].as_int() < 0) {
+      return ExecutionResult::make_error("negative shift");
+   }
+   int width = context.int_width();
+   uint64_t bits = static_cast<uint64_t>(input[0].as_int()) & bitops::Mask(width);
+   uint64_t count = static_cast<uint64_t>(input[1].as_int());
+   return ExecutionResult::make_success({Value(bitops::SignExtend(op(bits, count, width), width))});
+}
+
+/// @brief op on two bitsets, otherwise on the bits of two ints
+template <typename Op>
+ExecutionResult BinarySet(
+   Context const& context, std::span<Value> input, bitset::SetOp set_op, Op op
+) {
+   if((input[0].type() == Value::Type::kBitset) && (input[1].type() == Value::Type::kBitset)) {
+      return ExecutionResult::make_success(
+         {Value(bitset::Combine(set_op, input[0].as_bitset(), input[1].as_bitset()))}
+      );
+   }
+   if((input[0].type() == Value::Type::kBitset) || (input[1].type() == Value::Type::kBitset)) {
+      return ExecutionResult::make_error("require (int int) or (bitset bitset)");
+   }
+   return BinaryBits(context, input, op);
+}
+
+ExecutionResult AndWord(Context& context, std::span<Value> input) {
+   return BinarySet(context, input, bitset::SetOp::kAnd, [](uint64_t a, uint64_t b, int) {
+      return a & b;
+   });
+}
+
+ExecutionResult OrWord(Context& context, std::span<Value> input) {
+   return BinarySet(context, input, bitset::SetOp::kOr, [](uint64_t a, uint64_t b, int) {
+      return a | b;
+   });
+}
+
+ExecutionResult XorWord(Context& context, std::span<Value> input) {
+   return BinarySet(context, input, bitset::SetOp::kXor, [](uint64_t a, uint64_t b, int) {
+      return a ^ b;
+   });
+}
+
+/// @brief `a b andnot` is a & ~b
+ExecutionResult AndNotWord(Context& context, std::span<Value> input) {
+   return BinarySet(context, input, bitset::SetOp::kAndNot, [](uint64_t a, uint64_t b, int) {
+      return a & ~b;
+   });
+}
+
+/// @brief `"0-3,64 bitset` from a range list, or an int's bits at the width
+ExecutionResult BitsetWord(Context& context, std::span<Value> input) {
+   switch(input[0].type()) {
+   case Value::Type::kBitset:
+      return ExecutionResult::make_success({std::move(input[0])});
+   case Value::Type::kInt: {
+      uint64_t bits = static_cast<uint64_t>(input[0].as_int()) & bitops::Mask(context.int_width());
+      return ExecutionResult::make_success({Value(bitset::FromInt(bits))});
+   }
+   case Value::Type::kString: {
+      BitWords words;
+      if(!bitset::ParseRangeList(input[0].as_string_view(), words)) {
+         return ExecutionResult::make_error("invalid range list");
+      }
+      return ExecutionResult::make_success({Value(std::move(words))});
+   }
+   default:
+      return ExecutionResult::make_error("require an int, a string or a bitset");
+   }
+}
+
+ExecutionResult NotWord(Context& context, std::span<Value> input) {
+   return UnaryBits(context, input, [](uint64_t bits, int) { return ~bits; });
+}
+
+ExecutionResult ShiftLeftWord(Context& context, std::span<Value> input) {
+   return Shift(context, input, &bitops::ShiftLeft);
+}
+
+/// @brief Logical, shifts in zeros
+ExecutionResult ShiftRightWord(Context& context, std::span<Value> input) {
+   return Shift(context, input, &bitops::ShiftRight);
+}
+
+ExecutionResult ShiftRightArithmeticWord(Context& context, std::span<Value> input) {
+   return Shift(context, input, &bitops::ShiftRightArithmetic);
+}
+
+/// @brief Any count, negative rotates the other way
+ExecutionResult RotateLeftWord(Context& context, std::span<Value> input) {
+   return BinaryBits(context, input, [&](uint64_t bits, uint64_t, int width) {
+      return bitops::RotateLeft(bits, input[1].as_int(), width);
+   });
+}
+
+ExecutionResult RotateRightWord(Context& context, std::span<Value> input) {
+   return BinaryBits(context, input, [&](uint64_t bits, uint64_t, int width) {
+      return bitops::RotateRight(bits, input[1].as_int(), width);
+   });
+}
+
+ExecutionResult PopCountWord(Context& context, std::span<Value> input) {
+   if(input[0].type() == Value::Type::kBitset) {
+      auto count = bitset::PopCount(input[0].as_bitset());
+      return ExecutionResult::make_success({Value(static_cast<int64_t>(count))});
+   }
+   return CountBits(context, input, &bitops::PopCount);
+}
+
+ExecutionResult CountLeadingZerosWord(Context& context, std::span<Value> input) {
+   return CountBits(context, input, &bitops::CountLeadingZeros);
+}
+
+ExecutionResult CountTrailingZerosWord(Context& context, std::span<Value> input) {
+   return CountBits(context, input, &bitops::CountTrailingZeros);
+}
+
+ExecutionResult BitReverseWord(Context& context, std::span<Value> input) {
+   return UnaryBits(context, input, &bitops::BitReverse);
+}
+
+ExecutionResult ByteSwapWord(Context& context, std::span<Value> input) {
+   return UnaryBits(context, input, &bitops::ByteSwap);
+}
+
+/// @brief `bits mask pext`
+ExecutionResult ParallelExtractWord(Context& context, std::span<Value> input) {
+   return BinaryBits(context, input, [](uint64_t bits, uint64_t mask, int) {
+      return bitops::ParallelExtract(bits, mask);
+   });
+}
+
+/// @brief `bits mask pdep`
+ExecutionResult ParallelDepositWord(Context& context, std::span<Value> input) {
+   return BinaryBits(context, input, [](uint64_t bits, uint64_t mask, int) {
+      return bitops::ParallelDeposit(bits, mask);
+   });
+}
+
+/// @brief `x y morton`, x in the even bits. Each takes half the width.
+ExecutionResult MortonEncodeWord(Context& context, std::span<Value> input) {
+   return BinaryBits(context, input, [](uint64_t x, uint64_t y, int width) {
+      uint64_t half = bitops::Mask(width / 2);
+      return bitops::MortonEncode(x & half, y & half);
+   });
+}
+
+/// @brief `code unmorton` gives x y
+ExecutionResult MortonDecodeWord(Context& context, std::span<Value> input) {
+   if(!AllInts(input)) {
+      return ExecutionResult::make_error("require an int");
+   }
+   uint64_t code = static_cast<uint64_t>(input[0].as_int()) & bitops::Mask(context.int_width());
+   uint64_t x = 0;
+   uint64_t y = 0;
+   bitops::MortonDecode(code, x, y);
+   return ExecutionResult::make_success(
+      {Value(static_cast<int64_t>(x)), Value(static_cast<int64_t>(y))}
+   );
+}
+
+ExecutionResult GrayEncodeWord(Context& context, std::span<Value> input) {
+   return UnaryBits(context, input, &bitops::GrayEncode);
+}
+
+ExecutionResult GrayDecodeWord(Context& context, std::span<Value> input) {
+   return UnaryBits(context, input, &bitops::GrayDecode);
+}
+
+/// @brief `a b clmul`, the low width bits of the carry-less product
+ExecutionResult CarrylessMultiplyWord(Context& context, std::span<Value> input) {
+   return BinaryBits(context, input, [](uint64_t a, uint64_t b, int) {
+      return gf2::CarrylessMultiply(a, b).low;
+   });
+}
+
+/// @brief The bits of the carry-less product above the width
+ExecutionResult CarrylessMultiplyHighWord(Context& context, std::span<Value> input) {
+   return BinaryBits(context, input, [](uint64_t a, uint64_t b, int width) {
+      auto product = gf2::CarrylessMultiply(a, b);
+      if(width == 64) {
+         return product.high;
+      }
+      return (product.low >> width) | (product.high << (64 - width));
+   });
+}
+
+/// @brief The generator of a GF(2) word, which is not masked to the width
+/// since it has one more bit than its remainders
+std::optional<uint64_t> Generator(Value const& value, int width) {
+   int degree = gf2::Degree(static_cast<uint64_t>(value.as_int()));
+   if((degree < 1) || (degree > std::min(width, 63))) {
+      return std::nullopt;
+   }
+   return static_cast<uint64_t>(value.as_int());
+}
+
+/// @brief op(operands, generator) for words whose last argument is a generator
+template <size_t operands, typename Op>
+ExecutionResult GeneratorOp(Context const& context, std::span<Value> input, Op op) {
+   if(!AllInts(input)) {
+      return ExecutionResult::make_error("require ints");
+   }
+   int width = context.int_width();
+   auto generator = Generator(input[operands], width);
+   if(!generator.has_value()) {
+      return ExecutionResult::make_error("generator degree must be 1 to the width");
+   }
+   std::array<uint64_t, operands> bits{};
+   for(size_t i = 0; i < operands; ++i) {
+      bits[i] = static_cast<uint64_t>(input[i].as_int()) & bitops::Mask(width);
+   }
+   return ExecutionResult::make_success({Value(bitops::SignExtend(op(bits, *generator), width))});
+}
+
+/// @brief `a generator pmod`
+ExecutionResult PolynomialModWord(Context& context, std::span<Value> input) {
+   return GeneratorOp<1>(context, input, [](auto bits, uint64_t generator) {
+      return gf2::Reduce(bits[0], generator);
+   });
+}
+
+/// @brief `a b generator pmulmod`, multiplication in GF(2^degree)
+ExecutionResult PolynomialMultiplyModWord(Context& context, std::span<Value> input) {
+   return GeneratorOp<2>(context, input, [](auto bits, uint64_t generator) {
+      return gf2::MultiplyMod(bits[0], bits[1], generator);
+   });
+}
+
+/// @brief `state generator lfsr`
+ExecutionResult LfsrStepWord(Context& context, std::span<Value> input) {
+   return GeneratorOp<1>(context, input, [](auto bits, uint64_t generator) {
+      return gf2::LfsrStep(bits[0], generator);
+   });
+}
+
+/// @brief `state generator steps lfsrjump`
+ExecutionResult LfsrJumpWord(Context& context, std::span<Value> input) {
+   if(!AllInts(input)) {
+      return ExecutionResult::make_error("require ints");
+   }
+   if(input[2].as_int() < 0) {
+      return ExecutionResult::make_error("negative step count");
+   }
+   auto steps = static_cast<uint64_t>(input[2].as_int());
+   return GeneratorOp<1>(context, input.first(2), [&](auto bits, uint64_t generator) {
+      return gf2::LfsrJump(bits[0], generator, steps);
+   });
+}
+
+/// @brief The operand of a lane word: an int is a 64-bit vector whatever the
+/// int width, a byte buffer of 8, 16 or 32 bytes is a 64, 128 or 256-bit one
+struct Vector {
+   std::array<uint8_t, lanes::kMaxVectorBytes> bytes{};
+   size_t size = 0;
+   bool is_int = false;
+
+   std::span<uint8_t const> view() const {
+      return {bytes.data(), size};
+   }
+   std::span<uint8_t> view() {
+      return {bytes.data(), size};
+   }
+};
+
+std::optional<Vector> ToVector(Value const& value) {
+   Vector vector;
+   if(value.type() == Value::Type::kInt) {
+      int64_t bits = value.as_int();
+      std::memcpy(vector.bytes.data(), &bits, sizeof(bits));
+      vector.size = sizeof(bits);
+      vector.is_int = true;
+      return vector;
+   }
+   if((value.type() == Value::Type::kBytes) && lanes::IsVectorSize(value.as_bytes().size())) {
+      auto bytes = value.as_bytes();
+      std::ranges::copy(bytes, vector.bytes.begin());
+      vector.size = bytes.size();
+      return vector;
+   }
+   return std::nullopt;
+}
+
+Value FromVector(Vector const& vector) {
+   if(vector.is_int) {
+      int64_t bits = 0;
+      std::memcpy(&bits, vector.bytes.data(), sizeof(bits));
+      return Value(bits);
+   }
+   auto bytes = vector.view();
+   return Value(Bytes(bytes.begin(), bytes.end()));
+}
+
+/// @brief `a b`, lane by lane like the SSE instruction the word is named
+/// after. The result has the kind of a.
+template <lanes::Op op, lanes::Lane lane>
+ExecutionResult LaneWord(Context& context, std::span<Value> input) {
+   auto a = ToVector(input[0]);
+   auto b = ToVector(input[1]);
+   if(!a.has_value() || !b.has_value() || (a->size != b->size)) {
+      return ExecutionResult::make_error("require two vectors of the same size");
+   }
+   Vector result = *a;
+   lanes::Apply(op, lane, a->view(), b->view(), result.view());
+   return ExecutionResult::make_success({FromVector(result)});
+}
+
+/// @brief `a control pshufb`
+ExecutionResult ShuffleBytesWord(Context& context, std::span<Value> input) {
+   auto a = ToVector(input[0]);
+   auto control = ToVector(input[1]);
+   if(!a.has_value() || !control.has_value() || (a->size != control->size)) {
+      return ExecutionResult::make_error("require two vectors of the same size");
+   }
+   Vector result = *a;
+   lanes::ShuffleBytes(a->view(), control->view(), result.view());
+   return ExecutionResult::make_success({FromVector(result)});
+}
+
+/// @brief `a order pshufd`
+ExecutionResult ShuffleDwordsWord(Context& context, std::span<Value> input) {
+   auto a = ToVector(input[0]);
+   if(!a.has_value() || (input[1].type() != Value::Type::kInt)) {
+      return ExecutionResult::make_error("require (vector int)");
+   }
+   if(a->size == 8) {
+      return ExecutionResult::make_error("require a 128 or 256-bit vector");
+   }
+   if((input[1].as_int() < 0) || (input[1].as_int() > 255)) {
+      return ExecutionResult::make_error("order must be 0 to 255");
+   }
+   Vector result = *a;
+   lanes::ShuffleDwords(a->view(), static_cast<uint8_t>(input[1].as_int()), result.view());
+   return ExecutionResult::make_success({FromVector(result)});
+}
+
+} // namespace
+
+Cost EstimateBuiltinCost(Builtin builtin, std::span<Value const> args) {
+   using enum Value::Type;
+   switch(builtin) {
+   case Builtin::kAdd:
+      if((args[0].type() == kString) && (args[1].type() == kString)) {
+         return CopyCost(args);
+      }
+      if((args[0].type() == kBytes) && (args[1].type() == kBytes)) {
+         uint64_t bytes = args[0].as_bytes().size() + args[1].as_bytes().size();
+         return Cost{.work = 1 + bytes, .bytes = bytes};
+      }
+      break;
+   case Builtin::kMultiply: {
+      // the repeated string, capped like the kernel caps it
+      auto const& text = (args[0].type() == kString) ? args[0] : args[1];
+      auto const& count = (args[0].type() == kString) ? args[1] : args[0];
+      if((text.type() == kString) && (count.type() == kInt) && (count.as_int() > 0)) {
+         uint64_t repeats = std::min<uint64_t>(count.as_int(), kMaxRepeatBytes);
+         uint64_t bytes = std::min<uint64_t>(text.heap_bytes() * repeats, kMaxRepeatBytes);
+         // the count is work even for an empty string, which is only cheap
+         // as long as the kernel does not loop over it
+         return Cost{.work = 1 + repeats + bytes, .bytes = bytes};
+      }
+   } break;
+   case Builtin::kBytes:
+   case Builtin::kStr:
+   case Builtin::kToHex:
+   case Builtin::kFromHex:
+   case Builtin::kToBase64:
+   case Builtin::kFromBase64: {
+      // no encoding more than doubles its input
+      uint64_t bytes = args[0].payload().size();
+      return Cost{.work = 1 + bytes, .bytes = 2 * bytes};
+   }
+   case Builtin::kBitset:
+      // a short range list can set every bit
+      return Cost{.work = 1 + args[0].payload().size(), .bytes = bitset::kMaxBits / 8};
+   case Builtin::kAnd:
+   case Builtin::kOr:
+   case Builtin::kXor:
+   case Builtin::kAndNot:
+   case Builtin::kPopCount:
+      if(args[0].type() == kBitset) {
+         uint64_t bytes = 0;
+         for(auto const& arg : args) {
+            bytes += arg.payload().size();
+         }
+         return Cost{.work = 1 + bytes / sizeof(uint64_t), .bytes = bytes};
+      }
+      break;
+   default:
+      break;
+   }
+   if(Info(builtin).has(BuiltinInfo::kScansArgs)) {
+      Cost cost;
+      for(auto const& arg : args) {
+         cost.work += arg.payload().size();
+      }
+      return cost;
+   }
+   return Info(builtin).has(BuiltinInfo::kCopiesArgs) ? CopyCost(args) : Cost{};
+}
+
+ExecutionResult ExecuteBuiltin(Builtin builtin, Context& context, std::span<Value> input) {
+   switch(builtin) {
+#define CALC_BUILTIN_CASE(id, name, arity, flags, handler) \
+   case Builtin::id: \
+      return handler(context, input);
+      CALC_BUILTINS(CALC_BUILTIN_CASE)
+#undef CALC_BUILTIN_CASE
+   }
+   return ExecutionResult::make_error("unknown builtin");
+}
+
+} // namespace calc
@@ -0,0 +1,251 @@
+#pragma once
+
+#include "calc/function.hpp"
+#include "calc/value.hpp"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace calc {
+class Context;
+
+/// @brief Every builtin word: X(id, name, arity, flags, handler). The handlers
+/// are defined in builtins.cpp. The lane words are named after the SSE
+/// instruction they behave like, see lanes.hpp.
+#define CALC_BUILTINS(X) \
+   X(kAdd, "+", 2, BuiltinInfo::kSuperPrecedence, AddWord) \
+   X(kSubtract, "-", 2, BuiltinInfo::kSuperPrecedence, SubtractWord) \
+   X(kMultiply, "*", 2, BuiltinInfo::kSuperPrecedence, MultiplyWord) \
+   X(kModulo, "%", 2, BuiltinInfo::kSuperPrecedence, ModuloWord) \
+   X(kDivide, "/", 2, BuiltinInfo::kSuperPrecedence, DivideWord) \
+   X(kDrop, "drop", 1, 0, DropWord) \
+   X(kDup, "dup", 1, BuiltinInfo::kCopiesArgs, DupWord) \
+   X(kDup2, "dup2", 2, BuiltinInfo::kCopiesArgs, Dup2Word) \
+   X(kSwap, "swap", 2, 0, SwapWord) \
+   X(kField, "field", 3, 0, FieldWord) \
+   X(kClearFields, "clearfields", 0, 0, ClearFieldsWord) \
+   X(kStore, "store", 2, 0, StoreWord) \
+   X(kLoad, "load", 1, BuiltinInfo::kReadsVariables, LoadWord) \
+   X(kBytes, "bytes", 1, BuiltinInfo::kScansArgs, BytesWord) \
+   X(kStr, "str", 1, BuiltinInfo::kScansArgs, StrWord) \
+   X(kLength, "len", 1, 0, LengthWord) \
+   X(kToHex, "tohex", 1, BuiltinInfo::kScansArgs, ToHexWord) \
+   X(kFromHex, "fromhex", 1, BuiltinInfo::kScansArgs, FromHexWord) \
+   X(kToBase64, "tob64", 1, BuiltinInfo::kScansArgs, ToBase64Word) \
+   X(kFromBase64, "fromb64", 1, BuiltinInfo::kScansArgs, FromBase64Word) \
+   X(kCrc8, "crc8", 1, BuiltinInfo::kScansArgs, Crc8Word) \
+   X(kCrc16, "crc16", 1, BuiltinInfo::kScansArgs, Crc16Word) \
+   X(kCrc32, "crc32", 1, BuiltinInfo::kScansArgs, Crc32Word) \
+   X(kCrc32c, "crc32c", 1, BuiltinInfo::kScansArgs, Crc32cWord) \
+   X(kCrc, "crc", 5, BuiltinInfo::kScansArgs, CrcWord) \
+   X(kCrcReflected, "crcr", 5, BuiltinInfo::kScansArgs, CrcReflectedWord) \
+   X(kFnv1a, "fnv1a", 1, BuiltinInfo::kScansArgs, Fnv1aWord) \
+   X(kXxHash64, "xxh64", 1, BuiltinInfo::kScansArgs, XxHash64Word) \
+   X(kAnd, "&", 2, BuiltinInfo::kSuperPrecedence, AndWord) \
+   X(kOr, "|", 2, BuiltinInfo::kSuperPrecedence, OrWord) \
+   X(kXor, "^", 2, BuiltinInfo::kSuperPrecedence, XorWord) \
+   X(kAndNot, "andnot", 2, 0, AndNotWord) \
+   X(kBitset, "bitset", 1, 0, BitsetWord) \
+   X(kNot, "~", 1, BuiltinInfo::kSuperPrecedence, NotWord) \
+   X(kShiftLeft, "<<", 2, BuiltinInfo::kSuperPrecedence, ShiftLeftWord) \
+   X(kShiftRight, ">>", 2, BuiltinInfo::kSuperPrecedence, ShiftRightWord) \
+   X(kShiftRightArithmetic, "sar", 2, 0, ShiftRightArithmeticWord) \
+   X(kRotateLeft, "rotl", 2, 0, RotateLeftWord) \
+   X(kRotateRight, "rotr", 2, 0, RotateRightWord) \
+   X(kPopCount, "popcnt", 1, 0, PopCountWord) \
+   X(kCountLeadingZeros, "clz", 1, 0, CountLeadingZerosWord) \
+   X(kCountTrailingZeros, "ctz", 1, 0, CountTrailingZerosWord) \
+   X(kBitReverse, "bitrev", 1, 0, BitReverseWord) \
+   X(kByteSwap, "bswap", 1, 0, ByteSwapWord) \
+   X(kParallelExtract, "pext", 2, 0, ParallelExtractWord) \
+   X(kParallelDeposit, "pdep", 2, 0, ParallelDepositWord) \
+   X(kMortonEncode, "morton", 2, 0, MortonEncodeWord) \
+   X(kMortonDecode, "unmorton", 1, 0, MortonDecodeWord) \
+   X(kGrayEncode, "gray", 1, 0, GrayEncodeWord) \
+   X(kGrayDecode, "ungray", 1, 0, GrayDecodeWord) \
+   X(kCarrylessMultiply, "clmul", 2, 0, CarrylessMultiplyWord) \
+   X(kCarrylessMultiplyHigh, "clmulh", 2, 0, CarrylessMultiplyHighWord) \
+   X(kPolynomialMod, "pmod", 2, 0, PolynomialModWord) \
+   X(kPolynomialMultiplyMod, "pmulmod", 3, 0, PolynomialMultiplyModWord) \
+   X(kLfsrStep, "lfsr", 2, 0, LfsrStepWord) \
+   X(kLfsrJump, "lfsrjump", 3, 0, LfsrJumpWord) \
+   X(kPaddb, "paddb", 2, 0, (LaneWord<lanes::Op::kAdd, lanes::Lane::kU8>)) \
+   X(kPaddw, "paddw", 2, 0, (LaneWord<lanes::Op::kAdd, lanes::Lane::kU16>)) \
+   X(kPaddd, "paddd", 2, 0, (LaneWord<lanes::Op::kAdd, lanes::Lane::kU32>)) \
+   X(kPaddq, "paddq", 2, 0, (LaneWord<lanes::Op::kAdd, lanes::Lane::kU64>)) \
+   X(kAddps, "addps", 2, 0, (LaneWord<lanes::Op::kAdd, lanes::Lane::kF32>)) \
+   X(kAddpd, "addpd", 2, 0, (LaneWord<lanes::Op::kAdd, lanes::Lane::kF64>)) \
+   X(kPaddsb, "paddsb", 2, 0, (LaneWord<lanes::Op::kAddSaturate, lanes::Lane::kI8>)) \
+   X(kPaddsw, "paddsw", 2, 0, (LaneWord<lanes::Op::kAddSaturate, lanes::Lane::kI16>)) \
+   X(kPaddusb, "paddusb", 2, 0, (LaneWord<lanes::Op::kAddSaturate, lanes::Lane::kU8>)) \
+   X(kPaddusw, "paddusw", 2, 0, (LaneWord<lanes::Op::kAddSaturate, lanes::Lane::kU16>)) \
+   X(kPminsb, "pminsb", 2, 0, (LaneWord<lanes::Op::kMin, lanes::Lane::kI8>)) \
+   X(kPminub, "pminub", 2, 0, (LaneWord<lanes::Op::kMin, lanes::Lane::kU8>)) \
+   X(kPminsw, "pminsw", 2, 0, (LaneWord<lanes::Op::kMin, lanes::Lane::kI16>)) \
+   X(kPminuw, "pminuw", 2, 0, (LaneWord<lanes::Op::kMin, lanes::Lane::kU16>)) \
+   X(kPminsd, "pminsd", 2, 0, (LaneWord<lanes::Op::kMin, lanes::Lane::kI32>)) \
+   X(kPminud, "pminud", 2, 0, (LaneWord<lanes::Op::kMin, lanes::Lane::kU32>)) \
+   X(kMinps, "minps", 2, 0, (LaneWord<lanes::Op::kMin, lanes::Lane::kF32>)) \
+   X(kMinpd, "minpd", 2, 0, (LaneWord<lanes::Op::kMin, lanes::Lane::kF64>)) \
+   X(kPmaxsb, "pmaxsb", 2, 0, (LaneWord<lanes::Op::kMax, lanes::Lane::kI8>)) \
+   X(kPmaxub, "pmaxub", 2, 0, (LaneWord<lanes::Op::kMax, lanes::Lane::kU8>)) \
+   X(kPmaxsw, "pmaxsw", 2, 0, (LaneWord<lanes::Op::kMax, lanes::Lane::kI16>)) \
+   X(kPmaxuw, "pmaxuw", 2, 0, (LaneWord<lanes::Op::kMax, lanes::Lane::kU16>)) \
+   X(kPmaxsd, "pmaxsd", 2, 0, (LaneWord<lanes::Op::kMax, lanes::Lane::kI32>)) \
+   X(kPmaxud, "pmaxud", 2, 0, (LaneWord<lanes::Op::kMax, lanes::Lane::kU32>)) \
+   X(kMaxps, "maxps", 2, 0, (LaneWord<lanes::Op::kMax, lanes::Lane::kF32>)) \
+   X(kMaxpd, "maxpd", 2, 0, (LaneWord<lanes::Op::kMax, lanes::Lane::kF64>)) \
+   X(kPcmpeqb, "pcmpeqb", 2, 0, (LaneWord<lanes::Op::kCompareEqual, lanes::Lane::kU8>)) \
+   X(kPcmpeqw, "pcmpeqw", 2, 0, (LaneWord<lanes::Op::kCompareEqual, lanes::Lane::kU16>)) \
+   X(kPcmpeqd, "pcmpeqd", 2, 0, (LaneWord<lanes::Op::kCompareEqual, lanes::Lane::kU32>)) \
+   X(kPcmpeqq, "pcmpeqq", 2, 0, (LaneWord<lanes::Op::kCompareEqual, lanes::Lane::kU64>)) \
+   X(kPcmpgtb, "pcmpgtb", 2, 0, (LaneWord<lanes::Op::kCompareGreater, lanes::Lane::kI8>)) \
+   X(kPcmpgtw, "pcmpgtw", 2, 0, (LaneWord<lanes::Op::kCompareGreater, lanes::Lane::kI16>)) \
+   X(kPcmpgtd, "pcmpgtd", 2, 0, (LaneWord<lanes::Op::kCompareGreater, lanes::Lane::kI32>)) \
+   X(kPcmpgtq, "pcmpgtq", 2, 0, (LaneWord<lanes::Op::kCompareGreater, lanes::Lane::kI64>)) \
+   X(kPshufb, "pshufb", 2, 0, ShuffleBytesWord) \
+   X(kPshufd, "pshufd", 2, 0, ShuffleDwordsWord)
+
+struct BuiltinInfo {
+   /// @brief Parsed even when directly adjacent to numbers or other words,
+   /// see Function::super_precedence
+   static constexpr uint8_t kSuperPrecedence = 1 << 0;
+   /// @brief Copies its arguments, so its cost grows with them, see CopyCost
+   static constexpr uint8_t kCopiesArgs = 1 << 1;
+   /// @brief See Function::reads_variables
+   static constexpr uint8_t kReadsVariables = 1 << 2;
+   /// @brief Reads every byte of its string or byte buffer arguments
+   static constexpr uint8_t kScansArgs = 1 << 3;
+
+   std::string_view name;
+   uint8_t arity;
+   uint8_t flags;
+
+   constexpr bool has(uint8_t flag) const {
+      return (flags & flag) != 0;
+   }
+};
+
+enum class Builtin : uint8_t {
+#define CALC_BUILTIN_ID(id, name, arity, flags, handler) id,
+   CALC_BUILTINS(CALC_BUILTIN_ID)
+#undef CALC_BUILTIN_ID
+};
+
+inline constexpr BuiltinInfo kBuiltins[] = {
+#define CALC_BUILTIN_INFO(id, name, arity, flags, handler) BuiltinInfo{name, arity, flags},
+   CALC_BUILTINS(CALC_BUILTIN_INFO)
+#undef CALC_BUILTIN_INFO
+};
+
+/// @brief Parsed word indices below this are builtins, see State::functions
+inline constexpr size_t kBuiltinCount = std::size(kBuiltins);
+
+constexpr BuiltinInfo const& Info(Builtin builtin) {
+   return kBuiltins[static_cast<size_t>(builtin)];
+}
+
+namespace detail {
+constexpr uint32_t NameHash(std::string_view name, uint32_t seed) {
+   uint32_t hash = 2166136261u ^ seed;
+   for(char c : name) {
+      hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+   }
+   return hash;
+}
+
+/// @brief Enough slots that a collision free seed is quick to find, also for
+/// compilers with a low limit on constant evaluation steps
+inline constexpr size_t kBuiltinSlots = std::bit_ceil(kBuiltinCount * 8);
+inline constexpr uint8_t kEmptySlot = 0xff;
+static_assert(kBuiltinCount < kEmptySlot);
+/// @brief MakeBuiltinHash's seed when none is collision free
+inline constexpr uint32_t kNoSeed = 0xffffffff;
+
+struct BuiltinHash {
+   uint32_t seed;
+   std::array<uint8_t, kBuiltinSlots> slots;
+};
+
+/// @brief Finds a seed that puts every builtin name in its own slot
+consteval BuiltinHash MakeBuiltinHash() {
+   for(uint32_t seed = 0; seed < 1000000; ++seed) {
+      BuiltinHash hash{seed, {}};
+      hash.slots.fill(kEmptySlot);
+      bool collision = false;
+      for(size_t i = 0; (i < kBuiltinCount) && !collision; ++i) {
+         auto& slot = hash.slots[NameHash(kBuiltins[i].name, seed) & (kBuiltinSlots - 1)];
+         collision = slot != kEmptySlot;
+         slot = static_cast<uint8_t>(i);
+      }
+      if(!collision) {
+         return hash;
+      }
+   }
+   return BuiltinHash{kNoSeed, {}};
+}
+
+inline constexpr BuiltinHash kBuiltinHash = MakeBuiltinHash();
+static_assert(
+   kBuiltinHash.seed != kNoSeed, "no collision free seed for the builtin names, raise kBuiltinSlots"
+);
+} // namespace detail
+
+/// @brief Looks a name up with one hash and one comparison
+constexpr std::optional<Builtin> FindBuiltin(std::string_view name) {
+   auto const& hash = detail::kBuiltinHash;
+   uint8_t index = hash.slots[detail::NameHash(name, hash.seed) & (detail::kBuiltinSlots - 1)];
+   if((index < kBuiltinCount) && (kBuiltins[index].name == name)) {
+      return static_cast<Builtin>(index);
+   }
+   return std::nullopt;
+}
+
+static_assert(
+   [] {
+      for(size_t i = 0; i < kBuiltinCount; ++i) {
+         if(FindBuiltin(kBuiltins[i].name) != static_cast<Builtin>(i)) {
+            return false;
+         }
+      }
+      return true;
+   }(),
+   "every builtin must be found by its name"
+);
+static_assert(FindBuiltin("dup2") == Builtin::kDup2);
+static_assert(FindBuiltin("dup3") == std::nullopt);
+static_assert(FindBuiltin("<<") == Builtin::kShiftLeft);
+static_assert(FindBuiltin("pcmpgtq") == Builtin::kPcmpgtq);
+
+/// @brief Builtins with BuiltinInfo::kSuperPrecedence, in table order
+inline constexpr auto kSuperPrecedenceBuiltins = [] {
+   constexpr size_t kCount = [] {
+      size_t count = 0;
+      for(auto const& info : kBuiltins) {
+         count += info.has(BuiltinInfo::kSuperPrecedence) ? 1 : 0;
+      }
+      return count;
+   }();
+   std::array<Builtin, kCount> builtins{};
+   size_t next = 0;
+   for(size_t i = 0; i < kBuiltinCount; ++i) {
+      if(kBuiltins[i].has(BuiltinInfo::kSuperPrecedence)) {
+         builtins[next++] = static_cast<Builtin>(i);
+      }
+   }
+   return builtins;
+}();
+
+/// @brief Estimate for a call, see Function::estimate_cost
+Cost EstimateBuiltinCost(Builtin builtin, std::span<Value const> args);
+
+/// @brief Runs a builtin. Dispatches with a switch, so the handlers can be
+/// inlined into it.
+Function::ExecutionResult ExecuteBuiltin(Builtin builtin, Context& context, std::span<Value> input);
+
+} // namespace calc
@@ -0,0 +1,180 @@
+#include "calc/byte_codec.hpp"
+
+#include <array>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace bytecodec {
+
+namespace {
+
+constexpr char kHexDigits[] = "0123456789abcdef";
+
+/// @brief Both hex digits of every byte
+constexpr auto kHexPairs = [] {
+   std::array<char, 256 * 2> table{};
+   for(size_t i = 0; i < 256; ++i) {
+      table[i * 2] = kHexDigits[i >> 4];
+      table[i * 2 + 1] = kHexDigits[i & 0xf];
+   }
+   return table;
+}();
+
+constexpr uint8_t kInvalid = 0xff;
+
+/// @brief Value of each hex digit, kInvalid for anything else
+constexpr auto kHexValues = [] {
+   std::array<uint8_t, 256> table{};
+   table.fill(kInvalid);
+   for(uint8_t i = 0; i < 16; ++i) {
+      table[static_cast<uint8_t>(kHexDigits[i])] = i;
+      table[static_cast<uint8_t>("0123456789ABCDEF"[i])] = i;
+   }
+   return table;
+}();
+
+constexpr char kBase64Digits[] =
+   "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/// @brief Value of each base64 digit, kInvalid for anything else
+constexpr auto kBase64Values = [] {
+   std::array<uint8_t, 256> table{};
+   table.fill(kInvalid);
+   for(uint8_t i = 0; i < 64; ++i) {
+      table[static_cast<uint8_t>(kBase64Digits[i])] = i;
+   }
+   return table;
+}();
+
+#if defined(__SSE2__)
+/// @brief Nibbles 0 to 15 to their lowercase hex digits
+__m128i HexDigitsOf(__m128i nibbles) {
+   __m128i letters = _mm_and_si128(
+      _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '0' - 10)
+   );
+   return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+}
+#endif
+
+} // namespace
+
+std::string EncodeHex(std::span<uint8_t const> bytes) {
+   std::string out(bytes.size() * 2, '\0');
+   uint8_t const* in = bytes.data();
+   char* dest = out.data();
+   size_t i = 0;
+#if defined(__SSE2__)
+   for(; i + 16 <= bytes.size(); i += 16) {
+      __m128i block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in + i));
+      __m128i high = _mm_and_si128(_mm_srli_epi16(block, 4), _mm_set1_epi8(0x0f));
+      __m128i low = _mm_and_si128(block, _mm_set1_epi8(0x0f));
+      // interleaved so each byte's high digit comes first
+      _mm_storeu_si128(
+         reinterpret_cast<__m128i*>(dest + i * 2), HexDigitsOf(_mm_unpacklo_epi8(high, low))
+      );
+      _mm_storeu_si128(
+         reinterpret_cast<__m128i*>(dest + i * 2 + 16), HexDigitsOf(_mm_unpackhi_epi8(high, low))
+      );
+   }
+#endif
+   for(; i < bytes.size(); ++i) {
+      std::memcpy(dest + i * 2, &kHexPairs[in[i] * 2], 2);
+   }
+   return out;
+}
+
+bool DecodeHex(std::string_view text, std::vector<uint8_t>& out) {
+   if((text.size() % 2) != 0) {
+      return false;
+   }
+   out.resize(text.size() / 2);
+   auto const* in = reinterpret_cast<uint8_t const*>(text.data());
+   uint8_t invalid = 0;
+   for(size_t i = 0; i < out.size(); ++i) {
+      uint8_t high = kHexValues[in[i * 2]];
+      uint8_t low = kHexValues[in[i * 2 + 1]];
+      invalid |= high | low;
+      out[i] = static_cast<uint8_t>((high << 4) | (low & 0xf));
+   }
+   // only kInvalid has bits above the low nibble
+   return (invalid & 0xf0) == 0;
+}
+
+std::string EncodeBase64(std::span<uint8_t const> bytes) {
+   std::string out(((bytes.size() + 2) / 3) * 4, '=');
+   uint8_t const* in = bytes.data();
+   char* dest = out.data();
+   size_t i = 0;
+   for(; i + 3 <= bytes.size(); i += 3, dest += 4) {
+      uint32_t triple = (uint32_t{in[i]} << 16) | (uint32_t{in[i + 1]} << 8) | in[i + 2];
+      dest[0] = kBase64Digits[triple >> 18];
+      dest[1] = kBase64Digits[(triple >> 12) & 0x3f];
+      dest[2] = kBase64Digits[(triple >> 6) & 0x3f];
+      dest[3] = kBase64Digits[triple & 0x3f];
+   }
+   size_t left = bytes.size() - i;
+   if(left > 0) {
+      uint32_t triple = uint32_t{in[i]} << 16;
+      if(left == 2) {
+         triple |= uint32_t{in[i + 1]} << 8;
+      }
+      dest[0] = kBase64Digits[triple >> 18];
+      dest[1] = kBase64Digits[(triple >> 12) & 0x3f];
+      if(left == 2) {
+         dest[2] = kBase64Digits[(triple >> 6) & 0x3f];
+      }
+   }
+   return out;
+}
+
+bool DecodeBase64(std::string_view text, std::vector<uint8_t>& out) {
+   if(text.ends_with('=')) {
+      if((text.size() % 4) != 0) {
+         return false;
+      }
+      text.remove_suffix(text.ends_with("==") ? 2 : 1);
+   }
+   if((text.size() % 4) == 1) {
+      return false;
+   }
+
+   out.resize(text.size() / 4 * 3 + ((text.size() % 4) == 0 ? 0 : (text.size() % 4) - 1));
+   auto const* in = reinterpret_cast<uint8_t const*>(text.data());
+   uint8_t* dest = out.data();
+   uint8_t invalid = 0;
+   size_t i = 0;
+   for(; i + 4 <= text.size(); i += 4, dest += 3) {
+      uint8_t a = kBase64Values[in[i]];
+      uint8_t b = kBase64Values[in[i + 1]];
+      uint8_t c = kBase64Values[in[i + 2]];
+      uint8_t d = kBase64Values[in[i + 3]];
+      invalid |= a | b | c | d;
+      uint32_t triple = (uint32_t{a} << 18) | (uint32_t{b} << 12) | (uint32_t{c} << 6) | d;
+      dest[0] = static_cast<uint8_t>(triple >> 16);
+      dest[1] = static_cast<uint8_t>(triple >> 8);
+      dest[2] = static_cast<uint8_t>(triple);
+   }
+   size_t left = text.size() - i;
+   bool canonical = true;
+   if(left > 0) {
+      uint8_t a = kBase64Values[in[i]];
+      uint8_t b = kBase64Values[in[i + 1]];
+      uint8_t c = (left == 3) ? kBase64Values[in[i + 2]] : 0;
+      invalid |= a | b | c;
+      // the bits of the last digit past the last byte are zero when encoded,
+      // anything else is a typo or a truncated encoding, e.g. "Zh==" for "f"
+      canonical = ((left == 3) ? (c & 0x03) : (b & 0x0f)) == 0;
+      uint32_t triple = (uint32_t{a} << 18) | (uint32_t{b} << 12) | (uint32_t{c} << 6);
+      dest[0] = static_cast<uint8_t>(triple >> 16);
+      if(left == 3) {
+         dest[1] = static_cast<uint8_t>(triple >> 8);
+      }
+   }
+   // only kInvalid has the top bits set
+   return canonical && ((invalid & 0xc0) == 0);
+}
+
+} // namespace bytecodec
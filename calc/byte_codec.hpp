@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Text encodings of byte buffers.
+///
+/// Encoders reserve the whole output up front and fill it in blocks. Hex
+/// encoding does 16 bytes per SSE2 step where SSE2 is available. Decoders look
+/// every character up in a 256-entry table and check validity once per block
+/// rather than per character.
+namespace bytecodec {
+
+/// @brief Lowercase, two digits per byte
+std::string EncodeHex(std::span<uint8_t const> bytes);
+
+/// @brief Decodes pairs of hex digits of either case. Returns false for an odd
+/// number of digits or any other character.
+bool DecodeHex(std::string_view text, std::vector<uint8_t>& out);
+
+/// @brief Standard alphabet, padded with '='
+std::string EncodeBase64(std::span<uint8_t const> bytes);
+
+/// @brief Decodes the standard alphabet, with or without padding. Returns
+/// false for any other character, an impossible length or a last digit with
+/// bits set past the last byte.
+bool DecodeBase64(std::string_view text, std::vector<uint8_t>& out);
+
+} // namespace bytecodec
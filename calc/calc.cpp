@@ -1,107 +1,94 @@
 
 #include "calc/calc.hpp"
+#include "calc/builtins.hpp"
 #include "calc/value.hpp"
+#include "perf/alloc_tracker.hpp"
+#include "perf/profiler.hpp"
 
+#include <algorithm>
 #include <format>
 #include <iostream>
 #include <iterator>
 #include <memory>
+#include <span>
 #include <variant>
 
 namespace calc {
 
-class DivideFunction : public BinaryArithmeticFunction {
-public:
-   DivideFunction() : BinaryArithmeticFunction("/") {}
-   Function::ExecutionResult execute(std::vector<Value> input) override {
-      // TODO support doubles
-      if(input[1].as_int() == 0) {
-         return ExecutionResult::make_error("div by zero");
-      }
-      return ExecutionResult::make_success(
-         std::vector<Value>{Value(int64_t{input[0].as_int() / input[1].as_int()})}
-      );
-   }
-};
+namespace {
+/// @brief A builtin with the same interface as Function, resolved without
+/// virtual calls
+struct BuiltinWord {
+   Builtin builtin;
 
-class DropFunction : public BuiltinNormalFunction {
-public:
-   DropFunction() : BuiltinNormalFunction(1, "drop") {}
-   Function::ExecutionResult execute(std::vector<Value> input) override {
-      return ExecutionResult::make_success();
+   size_t arity() const {
+      return Info(builtin).arity;
    }
-};
-class DupFunction : public BuiltinNormalFunction {
-public:
-   DupFunction() : BuiltinNormalFunction(1, "dup") {}
-   Function::ExecutionResult execute(std::vector<Value> input) override {
-      return ExecutionResult::make_success(std::vector<Value>{input[0], input[0]});
+   bool allow_speculative_execution() const {
+      return true;
    }
-};
-
-class Dup2Function : public BuiltinNormalFunction {
-public:
-   Dup2Function() : BuiltinNormalFunction(2, "dup2") {}
-   Function::ExecutionResult execute(std::vector<Value> input) override {
-      return ExecutionResult::make_success(
-         std::vector<Value>{input[0], input[1], input[0], input[1]}
-      );
+   bool reads_variables() const {
+      return Info(builtin).has(BuiltinInfo::kReadsVariables);
    }
-};
-
-class SwapFunction : public BuiltinNormalFunction {
-public:
-   SwapFunction() : BuiltinNormalFunction(2, "swap") {}
-   Function::ExecutionResult execute(std::vector<Value> input) override {
-      return ExecutionResult::make_success(std::vector<Value>{input[1], input[0]});
+   Cost estimate_cost(std::span<Value const> args) const {
+      return EstimateBuiltinCost(builtin, args);
+   }
+   Function::ExecutionResult execute_in(Context& context, std::span<Value> input) const {
+      return ExecuteBuiltin(builtin, context, input);
    }
 };
+} // namespace
 
-#define SIMPLE_BIN_OP(op) \
-   fns.push_back(std::make_unique<calc::SimpleBinaryArithmeticFunction>(#op, [](auto a, auto b) { \
-      return a op b; \
-   }));
-
-static std::vector<std::unique_ptr<calc::Function>> MakeBuiltinFunctions() {
-   std::vector<std::unique_ptr<calc::Function>> fns;
-   SIMPLE_BIN_OP(+);
-   SIMPLE_BIN_OP(-);
-   SIMPLE_BIN_OP(*);
-   SIMPLE_BIN_OP(%);
-   fns.push_back(std::make_unique<DivideFunction>());
-   fns.push_back(std::make_unique<DropFunction>());
-   fns.push_back(std::make_unique<Dup2Function>());
-   fns.push_back(std::make_unique<DupFunction>());
-   fns.push_back(std::make_unique<SwapFunction>());
-   return fns;
+bool State::AllowsSpeculativeExecution(size_t function_index) const {
+   if(function_index < kBuiltinCount) {
+      return true;
+   }
+   return functions[function_index - kBuiltinCount]->allow_speculative_execution();
 }
 
-State::State() {
-   auto builtins = MakeBuiltinFunctions();
-   functions.insert(
-      functions.end(),
-      std::make_move_iterator(builtins.begin()),
-      std::make_move_iterator(builtins.end())
-   );
+void State::Execute(std::vector<parse::Token>& tokens, bool is_speculative) {
+   Execute(committed, tokens, is_speculative);
 }
 
-void State::Execute(std::vector<parse::Token>& tokens, bool is_speculative) {
+void State::Execute(Context start, std::vector<parse::Token>& tokens, bool is_speculative) {
+   PROFILE_ZONE("State::Execute");
+   ALLOC_PHASE(alloc_tracker::Phase::kExecute);
+   // nothing from the last Execute is still allocated in it
+   m_scratch.reset();
+   ScopedScratch scratch(&m_scratch);
    speculate_poisoned = false;
-   speculative_stack = committed_stack;
+   speculative = std::move(start);
+   speculative_low_water = speculative.stack().data.size();
+   speculative_read_variables = false;
+   speculation_deferred = false;
+   if(is_speculative) {
+      m_speculation_spent = Cost{.work = 0, .bytes = 0};
+      m_speculation_start = std::chrono::steady_clock::now();
+   }
    for(auto& token : tokens) {
       ExecuteToken(token, is_speculative);
    }
 }
+
 void State::Commit() {
-   committed_stack = speculative_stack;
+   committed = speculative;
+   ++committed_version;
 }
 
 void State::PoisionSpeculation() {
    speculate_poisoned = true;
 }
 
+bool State::ChargeSpeculation(Cost cost) {
+   m_speculation_spent.work += cost.work;
+   m_speculation_spent.bytes += cost.bytes;
+   return (m_speculation_spent.work <= speculation_budget.work) &&
+          (m_speculation_spent.bytes <= speculation_budget.bytes) &&
+          (std::chrono::steady_clock::now() - m_speculation_start <= speculation_budget.time);
+}
+
 bool State::CheckSpecStackSize(std::size_t size) {
-   if(speculative_stack.data.size() < size) {
+   if(speculative.stack().data.size() < size) {
       PoisionSpeculation();
       return false;
    } else {
@@ -109,6 +96,57 @@ bool State::CheckSpecStackSize(std::size_t size) {
    }
 }
 
+template <typename Word>
+void State::ExecuteWord(parse::Token& token, bool is_speculative, Word& word) {
+   if(is_speculative && !word.allow_speculative_execution()) {
+      token.additional_popup_text = " [enter to execute] ";
+      PoisionSpeculation();
+      return;
+   }
+
+   size_t depth = speculative.stack().data.size();
+   if(depth < word.arity()) {
+      token.into_error(std::format("stack underflow: require {}, got {}", word.arity(), depth));
+      speculative_low_water = 0;
+      PoisionSpeculation();
+      return;
+   }
+
+   size_t index = depth - word.arity();
+   if(is_speculative) {
+      auto args = std::span<Value const>(speculative.stack().data).subspan(index);
+      if(!ChargeSpeculation(word.estimate_cost(args)) || m_scratch.exhausted()) {
+         token.additional_popup_text = " [enter to execute] ";
+         speculation_deferred = true;
+         PoisionSpeculation();
+         return;
+      }
+   }
+
+   auto& stack = speculative.edit_stack().data;
+   speculative_low_water = std::min(speculative_low_water, index);
+   speculative_read_variables = speculative_read_variables || word.reads_variables();
+   ScratchValues input(
+      std::make_move_iterator(stack.begin() + index),
+      std::make_move_iterator(stack.end()),
+      &m_scratch
+   );
+   stack.erase(stack.begin() + index, stack.end());
+   auto results = word.execute_in(speculative, input);
+   // the function may have written the context, which can move the stack
+   auto& after = speculative.edit_stack().data;
+   if(results.is_error) {
+      token.into_error(std::move(results.error));
+      // a failed word changes nothing, whether it ran on commit or not
+      after.insert(after.end(), input.begin(), input.end());
+      PoisionSpeculation();
+   } else {
+      for(auto& result : results.returns) {
+         after.push_back(std::move(result));
+      }
+   }
+}
+
 void State::ExecuteToken(parse::Token& token, bool is_speculative) {
    if(speculate_poisoned) {
       return;
@@ -120,45 +158,22 @@ void State::ExecuteToken(parse::Token& token, bool is_speculative) {
    case parse::TokenType::kBinaryNumber:
    case parse::TokenType::kDouble:
    case parse::TokenType::kString:
-      speculative_stack.push(token.push_value);
+   case parse::TokenType::kBytes:
+   case parse::TokenType::kBitset:
+      speculative.edit_stack().push(token.push_value);
       break;
-   case parse::TokenType::kWord: {
-      auto& fn = functions[token.function_index];
-      if(is_speculative && !fn->allow_speculative_execution()) {
-         token.additional_popup_text = " [enter to execute] ";
-         PoisionSpeculation();
-         return;
-      }
-
-      if(speculative_stack.data.size() < fn->arity()) {
-         token.into_error(std::format(
-            "stack underflow: require {}, got {}",
-            fn->arity(),
-            speculative_stack.data.size()
-         ));
-         PoisionSpeculation();
-         return;
-      }
-
-      std::vector<Value> input;
-      size_t index = speculative_stack.data.size() - fn->arity();
-      for(size_t i = 0; i < fn->arity(); ++i) {
-         input.push_back(std::move(speculative_stack.data[index]));
-         speculative_stack.data.erase(speculative_stack.data.begin() + index);
-      }
-      auto results = fn->execute(input);
-      if(results.is_error) {
-         token.into_error(std::move(results.error));
-         PoisionSpeculation();
+   case parse::TokenType::kWord:
+      if(token.function_index < kBuiltinCount) {
+         BuiltinWord word{static_cast<Builtin>(token.function_index)};
+         ExecuteWord(token, is_speculative, word);
       } else {
-         for(auto& result : results.returns) {
-            speculative_stack.push(std::move(result));
-         }
+         ExecuteWord(token, is_speculative, *functions[token.function_index - kBuiltinCount]);
       }
-   } break;
+      break;
    case parse::TokenType::kError:
       PoisionSpeculation();
       break;
    }
 }
+
 } // namespace calc
@@ -1,43 +1,83 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <vector>
 
+#include "calc/context.hpp"
 #include "calc/function.hpp"
 #include "calc/parse.hpp"
+#include "calc/scratch_arena.hpp"
 #include "calc/value.hpp"
 
 namespace calc {
 
-struct Stack {
-   std::vector<Value> data;
-
-   Value pop() {
-      auto ret = data.back();
-      data.pop_back();
-      return ret;
-   }
-
-   void push(Value n) {
-      data.push_back(n);
-   }
+/// @brief Limits on a single speculative Execute, which runs on every
+/// keystroke. A word that would go over them is deferred until the input is
+/// committed, like a word with side effects.
+struct SpeculationBudget {
+   uint64_t work = uint64_t{1} << 20;
+   uint64_t bytes = uint64_t{16} << 20;
+   /// @brief Checked before each word, a word that is already running is not
+   /// interrupted
+   std::chrono::microseconds time{2000};
 };
 
 class State {
 public:
-   State();
-   Stack committed_stack;
-   Stack speculative_stack;
+   /// @brief Capacity of the arena for word arguments and results. A
+   /// speculative Execute that needs more stops like one over budget.
+   static constexpr size_t kScratchBytes = 256 << 10;
+
+   /// @brief State as of the last Commit
+   Context committed;
+   /// @brief State after the last Execute
+   Context speculative;
    bool speculate_poisoned = false;
+   /// @brief Bumped by every Commit, identifies the committed contents
+   uint64_t committed_version = 0;
+   /// @brief Lowest index of the starting stack the last Execute read or
+   /// removed. Values below it did not affect the result. Zero after a stack
+   /// underflow, since the result then depends on the stack size.
+   size_t speculative_low_water = 0;
+   /// @brief The last Execute ran a word that reads variables
+   bool speculative_read_variables = false;
+   SpeculationBudget speculation_budget;
+   /// @brief The last speculative Execute stopped at a word that was over
+   /// the budget, so its result says nothing about the input
+   bool speculation_deferred = false;
 
-   std::vector<std::unique_ptr<Function>> functions;
+   /// @brief Words registered at runtime. Builtins are not in here, a parsed
+   /// word index below kBuiltinCount is a builtin and the rest index this
+   /// list offset by kBuiltinCount.
+   FunctionRegistry functions;
 
+   /// @brief False for words that only run on commit
+   bool AllowsSpeculativeExecution(size_t function_index) const;
+
+   /// @brief Runs the tokens on top of the committed context. A word that
+   /// fails stops execution and leaves its arguments on the stack.
    void Execute(std::vector<parse::Token>& tokens, bool is_speculative);
+   /// @brief Runs the tokens on top of start instead. Moving the context in
+   /// lets execution change it in place rather than copy the parts it writes.
+   void Execute(Context start, std::vector<parse::Token>& tokens, bool is_speculative);
+   /// @brief Makes the speculative context the committed one. Only copies
+   /// pointers, see Context.
    void Commit();
 
 private:
+   ScratchArena m_scratch{kScratchBytes};
+   Cost m_speculation_spent;
+   std::chrono::steady_clock::time_point m_speculation_start;
+
    void ExecuteToken(parse::Token& token, bool is_speculative);
+   /// @brief Word is a Function or a builtin, which is called without
+   /// virtual dispatch
+   template <typename Word> void ExecuteWord(parse::Token& token, bool is_speculative, Word& word);
+   /// @brief Charges the cost to the speculation budget, false if it does
+   /// not fit
+   bool ChargeSpeculation(Cost cost);
    void PoisionSpeculation();
    bool CheckSpecStackSize(std::size_t size);
 };
@@ -0,0 +1,242 @@
+#include "calc/checksum.hpp"
+
+#include <array>
+#include <bit>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+namespace checksum {
+
+namespace {
+
+/// @brief Entry [k][b] is the register after byte b and then k zero bytes
+using CrcTables = std::array<std::array<uint64_t, 256>, 8>;
+
+constexpr uint64_t WidthMask(int width) {
+   return (width >= 64) ? ~uint64_t{0} : (uint64_t{1} << width) - 1;
+}
+
+constexpr uint64_t Reflect(uint64_t bits, int width) {
+   uint64_t reflected = 0;
+   for(int i = 0; i < width; ++i) {
+      reflected |= ((bits >> i) & 1) << (width - 1 - i);
+   }
+   return reflected;
+}
+
+// Reflected models keep the register in the low bits and shift right, the
+// others keep it in the high bits and shift left, so any width uses one table
+// layout.
+
+constexpr CrcTables MakeCrcTables(CrcModel const& model) {
+   CrcTables tables{};
+   auto& first = tables[0];
+   if(model.reflect) {
+      uint64_t poly = Reflect(model.poly & WidthMask(model.width), model.width);
+      for(uint64_t b = 0; b < 256; ++b) {
+         uint64_t crc = b;
+         for(int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? ((crc >> 1) ^ poly) : (crc >> 1);
+         }
+         first[b] = crc;
+      }
+      for(size_t k = 1; k < tables.size(); ++k) {
+         for(size_t b = 0; b < 256; ++b) {
+            uint64_t previous = tables[k - 1][b];
+            tables[k][b] = (previous >> 8) ^ first[previous & 0xff];
+         }
+      }
+   } else {
+      uint64_t poly = (model.poly & WidthMask(model.width)) << (64 - model.width);
+      for(uint64_t b = 0; b < 256; ++b) {
+         uint64_t crc = b << 56;
+         for(int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 63) ? ((crc << 1) ^ poly) : (crc << 1);
+         }
+         first[b] = crc;
+      }
+      for(size_t k = 1; k < tables.size(); ++k) {
+         for(size_t b = 0; b < 256; ++b) {
+            uint64_t previous = tables[k - 1][b];
+            tables[k][b] = (previous << 8) ^ first[previous >> 56];
+         }
+      }
+   }
+   return tables;
+}
+
+constexpr CrcTables kCrc8Tables = MakeCrcTables(kCrc8);
+constexpr CrcTables kCrc16Tables = MakeCrcTables(kCrc16);
+constexpr CrcTables kCrc32Tables = MakeCrcTables(kCrc32);
+constexpr CrcTables kCrc32cTables = MakeCrcTables(kCrc32c);
+
+uint64_t LoadLittle64(uint8_t const* in) {
+   uint64_t word = 0;
+   for(int i = 7; i >= 0; --i) {
+      word = (word << 8) | in[i];
+   }
+   return word;
+}
+
+uint32_t LoadLittle32(uint8_t const* in) {
+   return uint32_t{in[0]} | (uint32_t{in[1]} << 8) | (uint32_t{in[2]} << 16) |
+          (uint32_t{in[3]} << 24);
+}
+
+uint64_t LoadBig64(uint8_t const* in) {
+   uint64_t word = 0;
+   for(int i = 0; i < 8; ++i) {
+      word = (word << 8) | in[i];
+   }
+   return word;
+}
+
+uint64_t RunCrc(CrcModel const& model, CrcTables const& t, std::span<uint8_t const> data) {
+   uint8_t const* in = data.data();
+   size_t n = data.size();
+   size_t i = 0;
+   uint64_t mask = WidthMask(model.width);
+   if(model.reflect) {
+      uint64_t crc = Reflect(model.init & mask, model.width);
+      for(; i + 8 <= n; i += 8) {
+         uint64_t word = LoadLittle64(in + i) ^ crc;
+         crc = t[7][word & 0xff] ^ t[6][(word >> 8) & 0xff] ^ t[5][(word >> 16) & 0xff] ^
+               t[4][(word >> 24) & 0xff] ^ t[3][(word >> 32) & 0xff] ^
+               t[2][(word >> 40) & 0xff] ^ t[1][(word >> 48) & 0xff] ^ t[0][word >> 56];
+      }
+      for(; i < n; ++i) {
+         crc = (crc >> 8) ^ t[0][(crc ^ in[i]) & 0xff];
+      }
+      return (crc ^ model.xorout) & mask;
+   }
+
+   int shift = 64 - model.width;
+   uint64_t crc = (model.init & mask) << shift;
+   for(; i + 8 <= n; i += 8) {
+      uint64_t word = LoadBig64(in + i) ^ crc;
+      crc = t[7][word >> 56] ^ t[6][(word >> 48) & 0xff] ^ t[5][(word >> 40) & 0xff] ^
+            t[4][(word >> 32) & 0xff] ^ t[3][(word >> 24) & 0xff] ^
+            t[2][(word >> 16) & 0xff] ^ t[1][(word >> 8) & 0xff] ^ t[0][word & 0xff];
+   }
+   for(; i < n; ++i) {
+      crc = (crc << 8) ^ t[0][(crc >> 56) ^ in[i]];
+   }
+   return ((crc >> shift) ^ model.xorout) & mask;
+}
+
+#if defined(__SSE4_2__)
+uint64_t HardwareCrc32c(std::span<uint8_t const> data) {
+   uint8_t const* in = data.data();
+   size_t i = 0;
+   uint64_t crc = kCrc32c.init;
+   for(; i + 8 <= data.size(); i += 8) {
+      crc = _mm_crc32_u64(crc, LoadLittle64(in + i));
+   }
+   auto crc32 = static_cast<uint32_t>(crc);
+   for(; i < data.size(); ++i) {
+      crc32 = _mm_crc32_u8(crc32, in[i]);
+   }
+   return crc32 ^ kCrc32c.xorout;
+}
+#endif
+
+constexpr uint64_t kXxPrime1 = 0x9e3779b185ebca87;
+constexpr uint64_t kXxPrime2 = 0xc2b2ae3d27d4eb4f;
+constexpr uint64_t kXxPrime3 = 0x165667b19e3779f9;
+constexpr uint64_t kXxPrime4 = 0x85ebca77c2b2ae63;
+constexpr uint64_t kXxPrime5 = 0x27d4eb2f165667c5;
+
+uint64_t XxRound(uint64_t acc, uint64_t input) {
+   acc += input * kXxPrime2;
+   return std::rotl(acc, 31) * kXxPrime1;
+}
+
+uint64_t XxMerge(uint64_t acc, uint64_t lane) {
+   acc ^= XxRound(0, lane);
+   return acc * kXxPrime1 + kXxPrime4;
+}
+
+} // namespace
+
+uint64_t Crc(CrcModel const& model, std::span<uint8_t const> data) {
+   if(model == kCrc32c) {
+#if defined(__SSE4_2__)
+      return HardwareCrc32c(data);
+#else
+      return RunCrc(model, kCrc32cTables, data);
+#endif
+   }
+   if(model == kCrc32) {
+      return RunCrc(model, kCrc32Tables, data);
+   }
+   if(model == kCrc16) {
+      return RunCrc(model, kCrc16Tables, data);
+   }
+   if(model == kCrc8) {
+      return RunCrc(model, kCrc8Tables, data);
+   }
+   CrcTables tables = MakeCrcTables(model);
+   return RunCrc(model, tables, data);
+}
+
+uint64_t Fnv1a64(std::span<uint8_t const> data) {
+   uint64_t hash = 0xcbf29ce484222325;
+   for(uint8_t byte : data) {
+      hash = (hash ^ byte) * 0x100000001b3;
+   }
+   return hash;
+}
+
+uint64_t XxHash64(std::span<uint8_t const> data, uint64_t seed) {
+   uint8_t const* in = data.data();
+   size_t n = data.size();
+   size_t i = 0;
+   uint64_t hash = 0;
+   if(n >= 32) {
+      // four independent lanes over 32-byte stripes
+      uint64_t lanes[4] = {
+         seed + kXxPrime1 + kXxPrime2,
+         seed + kXxPrime2,
+         seed,
+         seed - kXxPrime1,
+      };
+      for(; i + 32 <= n; i += 32) {
+         for(int lane = 0; lane < 4; ++lane) {
+            lanes[lane] = XxRound(lanes[lane], LoadLittle64(in + i + lane * 8));
+         }
+      }
+      hash = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) +
+             std::rotl(lanes[3], 18);
+      for(uint64_t lane : lanes) {
+         hash = XxMerge(hash, lane);
+      }
+   } else {
+      hash = seed + kXxPrime5;
+   }
+   hash += n;
+
+   for(; i + 8 <= n; i += 8) {
+      hash ^= XxRound(0, LoadLittle64(in + i));
+      hash = std::rotl(hash, 27) * kXxPrime1 + kXxPrime4;
+   }
+   if(i + 4 <= n) {
+      hash ^= uint64_t{LoadLittle32(in + i)} * kXxPrime1;
+      hash = std::rotl(hash, 23) * kXxPrime2 + kXxPrime3;
+      i += 4;
+   }
+   for(; i < n; ++i) {
+      hash ^= in[i] * kXxPrime5;
+      hash = std::rotl(hash, 11) * kXxPrime1;
+   }
+
+   hash ^= hash >> 33;
+   hash *= kXxPrime2;
+   hash ^= hash >> 29;
+   hash *= kXxPrime3;
+   hash ^= hash >> 32;
+   return hash;
+}
+
+} // namespace checksum
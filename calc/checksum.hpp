@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+/// CRCs of any width and polynomial, and non-cryptographic hashes.
+///
+/// A CRC is run slice-by-8: eight table lookups fold in eight bytes at a time.
+/// The named models below have their tables built at compile time. Other
+/// models build theirs per call, which costs about as much as 2 KiB of input.
+/// When the target has SSE4.2, CRC-32C uses the crc32 instruction instead.
+namespace checksum {
+
+/// @brief A CRC in the usual parameter model, see the CRC catalogue
+struct CrcModel {
+   /// @brief 1 to 64
+   int width;
+   /// @brief Without the top bit, not reflected
+   uint64_t poly;
+   uint64_t init;
+   /// @brief Whether input bytes and the result are bit reversed
+   bool reflect;
+   uint64_t xorout;
+
+   constexpr bool operator==(CrcModel const& other) const = default;
+};
+
+/// @brief CRC-8/SMBUS
+inline constexpr CrcModel kCrc8{8, 0x07, 0, false, 0};
+/// @brief CRC-16/ARC
+inline constexpr CrcModel kCrc16{16, 0x8005, 0, true, 0};
+/// @brief CRC-32/ISO-HDLC, as used by zlib and Ethernet
+inline constexpr CrcModel kCrc32{32, 0x04c11db7, 0xffffffff, true, 0xffffffff};
+/// @brief CRC-32C/ISCSI, Castagnoli
+inline constexpr CrcModel kCrc32c{32, 0x1edc6f41, 0xffffffff, true, 0xffffffff};
+
+/// @brief The model's width must be 1 to 64
+uint64_t Crc(CrcModel const& model, std::span<uint8_t const> data);
+
+/// @brief 64-bit FNV-1a
+uint64_t Fnv1a64(std::span<uint8_t const> data);
+
+/// @brief 64-bit xxHash
+uint64_t XxHash64(std::span<uint8_t const> data, uint64_t seed = 0);
+
+} // namespace checksum
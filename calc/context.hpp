@@ -0,0 +1,114 @@
+#pragma once
+
+#include "calc/bit_register.hpp"
+#include "calc/value.hpp"
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace calc {
+
+struct Stack {
+   std::vector<Value> data;
+
+   Value pop() {
+      auto ret = data.back();
+      data.pop_back();
+      return ret;
+   }
+
+   void push(Value n) {
+      data.push_back(n);
+   }
+};
+
+using Variables = std::map<std::string, Value, std::less<>>;
+
+/// @brief Everything executing words can read or change: the stack, the
+/// register layout, the variables and the int width.
+///
+/// The parts are shared between copies and copied the first time a shared
+/// part is written, so copying a context, e.g. to start speculating on top of
+/// the committed state or to commit the speculative one, only copies pointers.
+class Context {
+public:
+   Stack const& stack() const {
+      return *m_stack;
+   }
+
+   RegisterDisplay const& reg() const {
+      return *m_reg;
+   }
+
+   Variables const& variables() const {
+      return *m_variables;
+   }
+
+   Stack& edit_stack() {
+      return Edit(m_stack);
+   }
+
+   RegisterDisplay& edit_reg() {
+      return Edit(m_reg);
+   }
+
+   Variables& edit_variables() {
+      return Edit(m_variables);
+   }
+
+   void set_stack(Stack stack) {
+      m_stack = std::make_shared<Stack>(std::move(stack));
+   }
+
+   /// @brief The register layout and variables as they are now, e.g. to
+   /// restore them later without copying
+   std::shared_ptr<RegisterDisplay const> const& shared_reg() const {
+      return m_reg;
+   }
+
+   std::shared_ptr<Variables const> const& shared_variables() const {
+      return m_variables;
+   }
+
+   void set_shared_reg(std::shared_ptr<RegisterDisplay const> reg) {
+      m_reg = std::move(reg);
+   }
+
+   void set_shared_variables(std::shared_ptr<Variables const> variables) {
+      m_variables = std::move(variables);
+   }
+
+   /// @brief Bits that bitwise words work on, 1 to 64. Their results are
+   /// sign extended from this width.
+   int int_width() const {
+      return m_int_width;
+   }
+
+   void set_int_width(int width) {
+      m_int_width = width;
+   }
+
+private:
+   std::shared_ptr<Stack const> m_stack = std::make_shared<Stack>();
+   std::shared_ptr<RegisterDisplay const> m_reg =
+      std::make_shared<RegisterDisplay>(std::vector<Field>());
+   std::shared_ptr<Variables const> m_variables = std::make_shared<Variables>();
+   int m_int_width = 64;
+
+   template <typename T> static T& Edit(std::shared_ptr<T const>& part) {
+      if(part.use_count() != 1) {
+         part = std::make_shared<T>(*part);
+      } else {
+         // another thread may have just dropped its copy, see its writes
+         std::atomic_thread_fence(std::memory_order_acquire);
+      }
+      // every part is allocated non-const, and no other context can see it now
+      return const_cast<T&>(*part);
+   }
+};
+
+} // namespace calc
@@ -0,0 +1,79 @@
+#include "calc/execution_cache.hpp"
+
+#include <functional>
+
+namespace calc {
+
+static uint64_t KeyHash(
+   std::string_view input, uint64_t settings_hash, uint64_t committed_version
+) {
+   uint64_t hash = std::hash<std::string_view>{}(input);
+   hash ^= settings_hash + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+   hash ^= committed_version + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+   return hash;
+}
+
+CachedExecution const* ExecutionCache::find(
+   std::string_view input, uint64_t settings_hash, uint64_t committed_version
+) {
+   auto it = m_index.find(KeyHash(input, settings_hash, committed_version));
+   if(it == m_index.end()) {
+      return nullptr;
+   }
+   auto& entry = *it->second;
+   if((entry.input != input) || (entry.settings_hash != settings_hash) ||
+      (entry.committed_version != committed_version)) {
+      // hash collision
+      return nullptr;
+   }
+   m_entries.splice(m_entries.begin(), m_entries, it->second);
+   return &entry.result;
+}
+
+void ExecutionCache::insert(
+   std::string_view input,
+   uint64_t settings_hash,
+   uint64_t committed_version,
+   CachedExecution result
+) {
+   size_t cost = 1 + result.tokens.size() + result.speculative.stack().data.size();
+   // one huge entry would flush everything else
+   if(cost > m_budget / 8) {
+      return;
+   }
+   uint64_t key_hash = KeyHash(input, settings_hash, committed_version);
+   if(auto it = m_index.find(key_hash); it != m_index.end()) {
+      m_cost -= it->second->cost;
+      m_entries.erase(it->second);
+      m_index.erase(it);
+   }
+   evict_to(m_budget - cost);
+
+   m_entries.push_front(Entry{
+      .key_hash = key_hash,
+      .input = std::string(input),
+      .settings_hash = settings_hash,
+      .committed_version = committed_version,
+      .result = std::move(result),
+      .cost = cost,
+   });
+   m_index.emplace(key_hash, m_entries.begin());
+   m_cost += cost;
+}
+
+void ExecutionCache::clear() {
+   m_entries.clear();
+   m_index.clear();
+   m_cost = 0;
+}
+
+void ExecutionCache::evict_to(size_t budget) {
+   while((m_cost > budget) && !m_entries.empty()) {
+      auto& oldest = m_entries.back();
+      m_cost -= oldest.cost;
+      m_index.erase(oldest.key_hash);
+      m_entries.pop_back();
+   }
+}
+
+} // namespace calc
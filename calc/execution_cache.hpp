@@ -0,0 +1,74 @@
+#pragma once
+
+#include "calc/calc.hpp"
+#include "calc/parse.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace calc {
+
+/// @brief Result of parsing and speculatively executing one input
+struct CachedExecution {
+   std::vector<parse::Token> tokens;
+   Context speculative;
+   bool speculate_poisoned = false;
+};
+
+/// @brief Bounded LRU cache of speculative execution results, keyed by the
+/// input text, the parser settings and the committed state they ran against.
+///
+/// Speculative execution has no side effects, so the same key always gives
+/// the same result. Entries for an old committed version are never hit again
+/// and age out. The bound is on the number of cached tokens plus stack
+/// values, so a few deep stacks cannot hold on to unbounded memory.
+class ExecutionCache {
+public:
+   static constexpr size_t kDefaultBudget = 1 << 18;
+
+   explicit ExecutionCache(size_t budget = kDefaultBudget) : m_budget(budget) {}
+
+   /// @brief The cached result, or nullptr. The pointer is valid until the
+   /// next insert or clear.
+   CachedExecution const* find(
+      std::string_view input, uint64_t settings_hash, uint64_t committed_version
+   );
+
+   void insert(
+      std::string_view input,
+      uint64_t settings_hash,
+      uint64_t committed_version,
+      CachedExecution result
+   );
+
+   void clear();
+
+   size_t size() const {
+      return m_entries.size();
+   }
+
+private:
+   struct Entry {
+      uint64_t key_hash;
+      std::string input;
+      uint64_t settings_hash;
+      uint64_t committed_version;
+      CachedExecution result;
+      size_t cost;
+   };
+
+   size_t m_budget;
+   size_t m_cost = 0;
+   /// @brief Most recently used first
+   std::list<Entry> m_entries;
+   std::unordered_map<uint64_t, std::list<Entry>::iterator> m_index;
+
+   void evict_to(size_t budget);
+};
+
+} // namespace calc
@@ -0,0 +1,12 @@
+#include "calc/function.hpp"
+
+#include <atomic>
+
+namespace calc {
+
+uint64_t FunctionRegistry::NextGeneration() {
+   static std::atomic<uint64_t> next{0};
+   return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace calc
@@ -1,17 +1,48 @@
 #pragma once
 
+#include "calc/scratch_arena.hpp"
 #include "calc/value.hpp"
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <initializer_list>
+#include <memory>
+#include <memory_resource>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
 
 namespace calc {
+class Context;
+
+/// @brief Values allocated from the ScratchResource
+using ScratchValues = std::pmr::vector<Value>;
+
+/// @brief Estimated resources for one function call
+struct Cost {
+   /// @brief Abstract work units, about one per value or string byte touched
+   uint64_t work = 1;
+   /// @brief Bytes allocated for the results
+   uint64_t bytes = 0;
+};
+
+/// @brief Cost of a call that copies its arguments
+inline Cost CopyCost(std::span<Value const> args) {
+   Cost cost;
+   for(auto const& arg : args) {
+      cost.work += arg.heap_bytes();
+      cost.bytes += arg.heap_bytes();
+   }
+   return cost;
+}
+
 class Function {
 public:
+   virtual ~Function() = default;
+
    virtual std::string_view name() const = 0;
    virtual size_t arity() const = 0;
    /// @brief If true, this function should always be parsed, even if it is
@@ -20,27 +51,54 @@ public:
       return false;
    }
 
+   /// @brief False for functions with side effects, they only run on commit
    virtual bool allow_speculative_execution() const {
       return true;
    }
 
+   /// @brief True if the result depends on the variables, not only on the
+   /// arguments
+   virtual bool reads_variables() const {
+      return false;
+   }
+
+   /// @brief Estimate for a call with these arguments. Speculative execution
+   /// checks it against State::speculation_budget before running the call, so
+   /// functions whose cost grows with their inputs should override this.
+   virtual Cost estimate_cost(std::span<Value const> args) const {
+      return Cost{};
+   }
+
    struct ExecutionResult {
       bool is_error;
-      std::vector<Value> returns;
+      ScratchValues returns;
       std::string error;
 
       static ExecutionResult make_success() {
-         return ExecutionResult(false, std::vector<Value>(), "");
+         return ExecutionResult(false, ScratchValues(ScratchResource()), "");
       }
-      static ExecutionResult make_success(std::vector<Value> returns) {
+      static ExecutionResult make_success(std::initializer_list<Value> returns) {
+         return ExecutionResult(false, ScratchValues(returns, ScratchResource()), "");
+      }
+      static ExecutionResult make_success(ScratchValues returns) {
          return ExecutionResult(false, std::move(returns), "");
       }
       static ExecutionResult make_error(std::string error) {
-         return ExecutionResult(true, std::vector<Value>(), std::move(error));
+         return ExecutionResult(true, ScratchValues(ScratchResource()), std::move(error));
       }
    };
 
-   virtual ExecutionResult execute(std::vector<Value> input) = 0;
+   /// @brief Run the function on its arguments, bottom of the stack first. A
+   /// function that fails must leave them unchanged, they go back on the
+   /// stack.
+   virtual ExecutionResult execute(std::span<Value> input) = 0;
+
+   /// @brief What State calls. Functions that read or change more than the
+   /// stack override this and get the context being executed in, which is
+   /// the speculative one while previewing.
+   virtual ExecutionResult execute_in(Context& context, std::span<Value> input) {
+      return execute(input);
+   }
 };
 
 class BuiltinNormalFunction : public Function {
@@ -59,46 +117,59 @@ private:
    std::string_view m_name;
 };
 
-class BinaryArithmeticFunction : public Function {
+/// @brief A function that needs the execution context, see
+/// Function::execute_in
+class ContextFunction : public BuiltinNormalFunction {
 public:
-   BinaryArithmeticFunction(char const* name) : m_name(name) {}
+   using BuiltinNormalFunction::BuiltinNormalFunction;
 
-   std::string_view name() const override {
-      return m_name;
+   ExecutionResult execute(std::span<Value> input) final {
+      return ExecutionResult::make_error("needs a context");
    }
+   ExecutionResult execute_in(Context& context, std::span<Value> input) override = 0;
+};
 
-   size_t arity() const override {
-      return 2;
+/// @brief Words registered at runtime, in the order parsed word indices refer
+/// to them. Every change gives the registry a new generation, unique across
+/// all registries, so anything cached from a parse can be keyed on it.
+class FunctionRegistry {
+public:
+   FunctionRegistry() : m_generation(NextGeneration()) {}
+
+   size_t size() const {
+      return m_functions.size();
    }
 
-   bool super_precedence() const {
-      return true;
+   std::unique_ptr<Function> const& operator[](size_t index) const {
+      return m_functions[index];
    }
 
-private:
-   char const* m_name;
-};
+   uint64_t generation() const {
+      return m_generation;
+   }
 
-class SimpleBinaryArithmeticFunction : public BinaryArithmeticFunction {
-public:
-   using FunctionType = std::int64_t (*)(std::int64_t, std::int64_t);
+   void push_back(std::unique_ptr<Function> function) {
+      m_functions.push_back(std::move(function));
+      m_generation = NextGeneration();
+   }
 
-   SimpleBinaryArithmeticFunction(char const* name, FunctionType fn) :
-      BinaryArithmeticFunction(name),
-      m_fn(fn) {}
+   /// @brief Tokens parsed before refer to the old function at index
+   void replace(size_t index, std::unique_ptr<Function> function) {
+      m_functions[index] = std::move(function);
+      m_generation = NextGeneration();
+   }
 
-   ExecutionResult execute(std::vector<Value> input) override {
-      // todo support floats
-      if((input[0].type() != Value::Type::kInt) || (input[1].type() != Value::Type::kInt)) {
-         return ExecutionResult::make_error("require two integer args");
-      }
-      return ExecutionResult::make_success(
-         std::vector<Value>{Value(m_fn(input[0].as_int(), input[1].as_int()))}
-      );
+   /// @brief Shifts the indices of the functions after it
+   void erase(size_t index) {
+      m_functions.erase(m_functions.begin() + static_cast<ptrdiff_t>(index));
+      m_generation = NextGeneration();
    }
 
 private:
-   FunctionType m_fn;
+   std::vector<std::unique_ptr<Function>> m_functions;
+   uint64_t m_generation;
+
+   static uint64_t NextGeneration();
 };
 
 } // namespace calc
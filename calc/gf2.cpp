@@ -0,0 +1,110 @@
+#include "calc/gf2.hpp"
+
+#if defined(__PCLMUL__)
+#include <wmmintrin.h>
+#endif
+
+namespace gf2 {
+
+Wide CarrylessMultiply(uint64_t a, uint64_t b) {
+#if defined(__PCLMUL__)
+   __m128i product = _mm_clmulepi64_si128(
+      _mm_cvtsi64_si128(static_cast<long long>(a)), _mm_cvtsi64_si128(static_cast<long long>(b)), 0
+   );
+   return Wide{
+      static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(product, product))),
+      static_cast<uint64_t>(_mm_cvtsi128_si64(product)),
+   };
+#else
+   Wide product{0, 0};
+   for(int i = 0; i < 64; ++i) {
+      if(((b >> i) & 1) != 0) {
+         product.low ^= a << i;
+         product.high ^= (i == 0) ? 0 : a >> (64 - i);
+      }
+   }
+   return product;
+#endif
+}
+
+uint64_t Reduce(Wide value, uint64_t generator) {
+   int degree = Degree(generator);
+   int top = (value.high != 0) ? 64 + Degree(value.high) : Degree(value.low);
+   // cancel the leading term with a shifted generator until the degree is
+   // below the generator's
+   for(int i = top; i >= degree; --i) {
+      uint64_t word = (i >= 64) ? value.high : value.low;
+      if(((word >> (i % 64)) & 1) == 0) {
+         continue;
+      }
+      int shift = i - degree;
+      if(shift >= 64) {
+         value.high ^= generator << (shift - 64);
+      } else {
+         value.low ^= generator << shift;
+         value.high ^= (shift == 0) ? 0 : generator >> (64 - shift);
+      }
+   }
+   return value.low;
+}
+
+Matrix Matrix::Identity() {
+   Matrix identity;
+   for(int j = 0; j < 64; ++j) {
+      identity.m_columns[j] = uint64_t{1} << j;
+   }
+   return identity;
+}
+
+Matrix Matrix::Companion(uint64_t generator) {
+   int degree = Degree(generator);
+   uint64_t low_terms = generator & ((uint64_t{1} << degree) - 1);
+   Matrix companion;
+   for(int j = 0; j + 1 < degree; ++j) {
+      companion.m_columns[j] = uint64_t{1} << (j + 1);
+   }
+   // x^(degree-1) * x wraps around to the generator's low terms
+   companion.m_columns[degree - 1] = low_terms;
+   return companion;
+}
+
+uint64_t Matrix::apply(uint64_t vector) const {
+   uint64_t result = 0;
+   for(; vector != 0; vector &= vector - 1) {
+      result ^= m_columns[std::countr_zero(vector)];
+   }
+   return result;
+}
+
+Matrix Matrix::operator*(Matrix const& other) const {
+   Matrix product;
+   for(int j = 0; j < 64; ++j) {
+      product.m_columns[j] = apply(other.m_columns[j]);
+   }
+   return product;
+}
+
+uint64_t LfsrStep(uint64_t state, uint64_t generator) {
+   int degree = Degree(generator);
+   state = Reduce(state, generator);
+   bool carry = ((state >> (degree - 1)) & 1) != 0;
+   state = (state << 1) & ((uint64_t{1} << degree) - 1);
+   return carry ? (state ^ (generator & ((uint64_t{1} << degree) - 1))) : state;
+}
+
+uint64_t LfsrJump(uint64_t state, uint64_t generator, uint64_t steps) {
+   state = Reduce(state, generator);
+   Matrix power = Matrix::Companion(generator);
+   while(steps != 0) {
+      if((steps & 1) != 0) {
+         state = power.apply(state);
+      }
+      steps >>= 1;
+      if(steps != 0) {
+         power = power * power;
+      }
+   }
+   return state;
+}
+
+} // namespace gf2
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+/// Arithmetic on polynomials over GF(2), stored one coefficient per bit with
+/// x^0 in bit 0.
+///
+/// A generator is given with its leading term, so its degree is its bit width
+/// minus one, and must be 1 to 63.
+namespace gf2 {
+
+struct Wide {
+   uint64_t high;
+   uint64_t low;
+};
+
+/// @brief The full product. Uses PCLMULQDQ when it is enabled.
+Wide CarrylessMultiply(uint64_t a, uint64_t b);
+
+/// @brief -1 for the zero polynomial
+inline int Degree(uint64_t polynomial) {
+   return static_cast<int>(std::bit_width(polynomial)) - 1;
+}
+
+/// @brief value mod generator
+uint64_t Reduce(Wide value, uint64_t generator);
+
+inline uint64_t Reduce(uint64_t value, uint64_t generator) {
+   return Reduce(Wide{0, value}, generator);
+}
+
+/// @brief a * b mod generator
+inline uint64_t MultiplyMod(uint64_t a, uint64_t b, uint64_t generator) {
+   return Reduce(CarrylessMultiply(a, b), generator);
+}
+
+/// @brief A linear map on vectors of up to 64 bits, column j is the image of
+/// bit j
+class Matrix {
+public:
+   static Matrix Identity();
+   /// @brief Multiplication by x mod generator, the step of a Galois LFSR
+   static Matrix Companion(uint64_t generator);
+
+   uint64_t apply(uint64_t vector) const;
+   /// @brief The map that applies other, then this
+   Matrix operator*(Matrix const& other) const;
+
+private:
+   std::array<uint64_t, 64> m_columns{};
+};
+
+/// @brief One step of the Galois LFSR with the generator as its feedback
+/// polynomial: the state times x mod generator
+uint64_t LfsrStep(uint64_t state, uint64_t generator);
+
+/// @brief Any number of steps, by raising the companion matrix to the
+/// power by squaring, so 2^40 steps take 40 squarings
+uint64_t LfsrJump(uint64_t state, uint64_t generator, uint64_t steps);
+
+} // namespace gf2
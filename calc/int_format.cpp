@@ -0,0 +1,152 @@
+#include "calc/int_format.hpp"
+
+#include <bit>
+#include <cstring>
+
+namespace intformat {
+
+namespace {
+
+constexpr char kDigits[] = "0123456789abcdef";
+
+/// @brief Both hex digits of every byte
+constexpr auto kHexPairs = [] {
+   std::array<char, 256 * 2> table{};
+   for(size_t i = 0; i < 256; ++i) {
+      table[i * 2] = kDigits[i >> 4];
+      table[i * 2 + 1] = kDigits[i & 0xf];
+   }
+   return table;
+}();
+
+/// @brief All eight binary digits of every byte
+constexpr auto kBinBytes = [] {
+   std::array<char, 256 * 8> table{};
+   for(size_t i = 0; i < 256; ++i) {
+      for(size_t bit = 0; bit < 8; ++bit) {
+         table[i * 8 + bit] = ((i >> (7 - bit)) & 1) ? '1' : '0';
+      }
+   }
+   return table;
+}();
+
+/// @brief "00" to "99"
+constexpr auto kDecPairs = [] {
+   std::array<char, 100 * 2> table{};
+   for(size_t i = 0; i < 100; ++i) {
+      table[i * 2] = kDigits[i / 10];
+      table[i * 2 + 1] = kDigits[i % 10];
+   }
+   return table;
+}();
+
+// Each writes the digits of `bits` without leading zeros right to left,
+// ending just before `end`, and returns where they start.
+
+char* HexDigits(uint64_t bits, char* end) {
+   while(bits > 0xff) {
+      end -= 2;
+      std::memcpy(end, &kHexPairs[(bits & 0xff) * 2], 2);
+      bits >>= 8;
+   }
+   if(bits > 0xf) {
+      end -= 2;
+      std::memcpy(end, &kHexPairs[bits * 2], 2);
+   } else {
+      *--end = kDigits[bits];
+   }
+   return end;
+}
+
+char* BinDigits(uint64_t bits, char* end) {
+   while(bits > 0xff) {
+      end -= 8;
+      std::memcpy(end, &kBinBytes[(bits & 0xff) * 8], 8);
+      bits >>= 8;
+   }
+   // the last byte without its leading zeros
+   size_t length = (bits == 0) ? 1 : static_cast<size_t>(std::bit_width(bits));
+   end -= length;
+   std::memcpy(end, &kBinBytes[bits * 8 + 8 - length], length);
+   return end;
+}
+
+char* OctDigits(uint64_t bits, char* end) {
+   do {
+      *--end = kDigits[bits & 7];
+      bits >>= 3;
+   } while(bits != 0);
+   return end;
+}
+
+char* DecDigits(uint64_t magnitude, char* end) {
+   while(magnitude >= 100) {
+      end -= 2;
+      std::memcpy(end, &kDecPairs[(magnitude % 100) * 2], 2);
+      magnitude /= 100;
+   }
+   if(magnitude >= 10) {
+      end -= 2;
+      std::memcpy(end, &kDecPairs[magnitude * 2], 2);
+   } else {
+      *--end = kDigits[magnitude];
+   }
+   return end;
+}
+
+} // namespace
+
+std::string_view Format(int64_t value, Options const& options, Buffer& buffer) {
+   int width = ((options.width < 1) || (options.width > 64)) ? 64 : options.width;
+   uint64_t mask = (width == 64) ? ~uint64_t{0} : (uint64_t{1} << width) - 1;
+   uint64_t bits = static_cast<uint64_t>(value) & mask;
+   bool negative = false;
+
+   // ungrouped digits, at most 64 for binary
+   std::array<char, 64> digits;
+   char* digits_end = digits.data() + digits.size();
+   char* first = nullptr;
+   switch(options.radix) {
+   case Radix::kHex:
+      first = HexDigits(bits, digits_end);
+      break;
+   case Radix::kOct:
+      first = OctDigits(bits, digits_end);
+      break;
+   case Radix::kBin:
+      first = BinDigits(bits, digits_end);
+      break;
+   case Radix::kDec:
+   default:
+      negative = ((bits >> (width - 1)) & 1) != 0;
+      first = DecDigits(negative ? ((~bits + 1) & mask) : bits, digits_end);
+      break;
+   }
+
+   char* end = buffer.chars.data() + buffer.chars.size();
+   char* out = end;
+   size_t count = static_cast<size_t>(digits_end - first);
+   if(options.group <= 0) {
+      out -= count;
+      std::memcpy(out, first, count);
+   } else {
+      // whole groups from the right, a separator before each but the first
+      auto group = static_cast<size_t>(options.group);
+      char const* in = digits_end;
+      while(count > group) {
+         in -= group;
+         out -= group;
+         std::memcpy(out, in, group);
+         *--out = options.separator;
+         count -= group;
+      }
+      out -= count;
+      std::memcpy(out, first, count);
+   }
+   if(negative) {
+      *--out = '-';
+   }
+   return std::string_view(out, static_cast<size_t>(end - out));
+}
+
+} // namespace intformat
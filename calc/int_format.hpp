@@ -0,0 +1,60 @@
+#pragma once
+
+#include "calc/intbase.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/// Integer to text in any radix the display uses, for a given int width.
+///
+/// Hex, octal and binary show the width's two's complement bit pattern, so
+/// -1 at width 8 is ff. Decimal shows the value the bits have as a signed
+/// width-bit integer. Separators are written while the digits are, into a
+/// fixed buffer, so formatting never allocates and the result is copied
+/// once.
+namespace intformat {
+
+enum class Radix { kDec, kHex, kOct, kBin };
+
+inline Radix FromIntBase(intbase::IntBase base) {
+   switch(base) {
+   case intbase::IntBase::kDec:
+      return Radix::kDec;
+   case intbase::IntBase::kHex:
+      return Radix::kHex;
+   case intbase::IntBase::kBin:
+      return Radix::kBin;
+   default:
+      return Radix::kDec;
+   }
+}
+
+struct Options {
+   Radix radix = Radix::kDec;
+   /// @brief 1 to 64
+   int width = 64;
+   /// @brief Digits between separators, 0 for none
+   int group = 0;
+   char separator = ',';
+};
+
+/// @brief 64 binary digits, 63 separators and room to spare
+inline constexpr size_t kMaxChars = 128;
+
+/// @brief Holds the text of one Format call
+struct Buffer {
+   std::array<char, kMaxChars> chars;
+};
+
+/// @brief Formats into buffer, the result points into it
+std::string_view Format(int64_t value, Options const& options, Buffer& buffer);
+
+inline std::string FormatToString(int64_t value, Options const& options) {
+   Buffer buffer;
+   return std::string(Format(value, options, buffer));
+}
+
+} // namespace intformat
@@ -0,0 +1,395 @@
+#include "calc/lanes.hpp"
+
+#include <array>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+namespace lanes {
+
+// lanes are loaded with memcpy, which puts lane 0 first like the SIMD units do
+static_assert(std::endian::native == std::endian::little);
+
+namespace {
+
+template <size_t bytes> struct UintOfSize;
+template <> struct UintOfSize<1> {
+   using type = uint8_t;
+};
+template <> struct UintOfSize<2> {
+   using type = uint16_t;
+};
+template <> struct UintOfSize<4> {
+   using type = uint32_t;
+};
+template <> struct UintOfSize<8> {
+   using type = uint64_t;
+};
+
+/// @brief The unsigned int with the same bits as T
+template <typename T> using Bits = typename UintOfSize<sizeof(T)>::type;
+
+template <typename T> T AllOnes() {
+   return std::bit_cast<T>(static_cast<Bits<T>>(~Bits<T>{0}));
+}
+
+template <typename T> T WrappingAdd(T a, T b) {
+   using U = Bits<T>;
+   return static_cast<T>(static_cast<U>(static_cast<U>(a) + static_cast<U>(b)));
+}
+
+template <typename T> T SaturatingAdd(T a, T b) {
+   T sum = WrappingAdd(a, b);
+   if constexpr(std::is_unsigned_v<T>) {
+      return (sum < a) ? std::numeric_limits<T>::max() : sum;
+   } else {
+      // overflow gives a sum with the other sign than both operands
+      bool negative = a < 0;
+      if(((b < 0) == negative) && ((sum < 0) != negative)) {
+         return negative ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max();
+      }
+      return sum;
+   }
+}
+
+template <typename T> T ScalarLane(Op op, T a, T b) {
+   switch(op) {
+   case Op::kAdd:
+   case Op::kAddSaturate:
+      if constexpr(std::is_floating_point_v<T>) {
+         return a + b;
+      } else {
+         return (op == Op::kAdd) ? WrappingAdd(a, b) : SaturatingAdd(a, b);
+      }
+   case Op::kMin:
+      return (a < b) ? a : b;
+   case Op::kMax:
+      return (a > b) ? a : b;
+   case Op::kCompareEqual:
+      return (a == b) ? AllOnes<T>() : T{};
+   case Op::kCompareGreater:
+      return (a > b) ? AllOnes<T>() : T{};
+   }
+   return T{};
+}
+
+template <typename T>
+void ScalarApply(Op op, uint8_t const* a, uint8_t const* b, uint8_t* out, size_t size) {
+   for(size_t i = 0; i < size; i += sizeof(T)) {
+      T x;
+      T y;
+      std::memcpy(&x, a + i, sizeof(T));
+      std::memcpy(&y, b + i, sizeof(T));
+      T result = ScalarLane(op, x, y);
+      std::memcpy(out + i, &result, sizeof(T));
+   }
+}
+
+#if defined(__SSE2__)
+/// @brief One 16-byte block, false if the targeted instruction sets have no
+/// instruction for this op and lane type
+bool SseBlock(Op op, Lane lane, __m128i a, __m128i b, __m128i& out) {
+   __m128 af = _mm_castsi128_ps(a);
+   __m128 bf = _mm_castsi128_ps(b);
+   __m128d ad = _mm_castsi128_pd(a);
+   __m128d bd = _mm_castsi128_pd(b);
+   switch(op) {
+   case Op::kAdd:
+      switch(lane) {
+      case Lane::kU8:
+      case Lane::kI8:
+         out = _mm_add_epi8(a, b);
+         return true;
+      case Lane::kU16:
+      case Lane::kI16:
+         out = _mm_add_epi16(a, b);
+         return true;
+      case Lane::kU32:
+      case Lane::kI32:
+         out = _mm_add_epi32(a, b);
+         return true;
+      case Lane::kU64:
+      case Lane::kI64:
+         out = _mm_add_epi64(a, b);
+         return true;
+      case Lane::kF32:
+         out = _mm_castps_si128(_mm_add_ps(af, bf));
+         return true;
+      case Lane::kF64:
+         out = _mm_castpd_si128(_mm_add_pd(ad, bd));
+         return true;
+      }
+      break;
+   case Op::kAddSaturate:
+      switch(lane) {
+      case Lane::kU8:
+         out = _mm_adds_epu8(a, b);
+         return true;
+      case Lane::kI8:
+         out = _mm_adds_epi8(a, b);
+         return true;
+      case Lane::kU16:
+         out = _mm_adds_epu16(a, b);
+         return true;
+      case Lane::kI16:
+         out = _mm_adds_epi16(a, b);
+         return true;
+      default:
+         break;
+      }
+      break;
+   case Op::kMin:
+      switch(lane) {
+      case Lane::kU8:
+         out = _mm_min_epu8(a, b);
+         return true;
+      case Lane::kI16:
+         out = _mm_min_epi16(a, b);
+         return true;
+#if defined(__SSE4_1__)
+      case Lane::kI8:
+         out = _mm_min_epi8(a, b);
+         return true;
+      case Lane::kU16:
+         out = _mm_min_epu16(a, b);
+         return true;
+      case Lane::kU32:
+         out = _mm_min_epu32(a, b);
+         return true;
+      case Lane::kI32:
+         out = _mm_min_epi32(a, b);
+         return true;
+#endif
+      case Lane::kF32:
+         out = _mm_castps_si128(_mm_min_ps(af, bf));
+         return true;
+      case Lane::kF64:
+         out = _mm_castpd_si128(_mm_min_pd(ad, bd));
+         return true;
+      default:
+         break;
+      }
+      break;
+   case Op::kMax:
+      switch(lane) {
+      case Lane::kU8:
+         out = _mm_max_epu8(a, b);
+         return true;
+      case Lane::kI16:
+         out = _mm_max_epi16(a, b);
+         return true;
+#if defined(__SSE4_1__)
+      case Lane::kI8:
+         out = _mm_max_epi8(a, b);
+         return true;
+      case Lane::kU16:
+         out = _mm_max_epu16(a, b);
+         return true;
+      case Lane::kU32:
+         out = _mm_max_epu32(a, b);
+         return true;
+      case Lane::kI32:
+         out = _mm_max_epi32(a, b);
+         return true;
+#endif
+      case Lane::kF32:
+         out = _mm_castps_si128(_mm_max_ps(af, bf));
+         return true;
+      case Lane::kF64:
+         out = _mm_castpd_si128(_mm_max_pd(ad, bd));
+         return true;
+      default:
+         break;
+      }
+      break;
+   case Op::kCompareEqual:
+      switch(lane) {
+      case Lane::kU8:
+      case Lane::kI8:
+         out = _mm_cmpeq_epi8(a, b);
+         return true;
+      case Lane::kU16:
+      case Lane::kI16:
+         out = _mm_cmpeq_epi16(a, b);
+         return true;
+      case Lane::kU32:
+      case Lane::kI32:
+         out = _mm_cmpeq_epi32(a, b);
+         return true;
+#if defined(__SSE4_1__)
+      case Lane::kU64:
+      case Lane::kI64:
+         out = _mm_cmpeq_epi64(a, b);
+         return true;
+#endif
+      case Lane::kF32:
+         out = _mm_castps_si128(_mm_cmpeq_ps(af, bf));
+         return true;
+      case Lane::kF64:
+         out = _mm_castpd_si128(_mm_cmpeq_pd(ad, bd));
+         return true;
+      default:
+         break;
+      }
+      break;
+   case Op::kCompareGreater:
+      // the int compares are signed only
+      switch(lane) {
+      case Lane::kI8:
+         out = _mm_cmpgt_epi8(a, b);
+         return true;
+      case Lane::kI16:
+         out = _mm_cmpgt_epi16(a, b);
+         return true;
+      case Lane::kI32:
+         out = _mm_cmpgt_epi32(a, b);
+         return true;
+#if defined(__SSE4_2__)
+      case Lane::kI64:
+         out = _mm_cmpgt_epi64(a, b);
+         return true;
+#endif
+      case Lane::kF32:
+         out = _mm_castps_si128(_mm_cmpgt_ps(af, bf));
+         return true;
+      case Lane::kF64:
+         out = _mm_castpd_si128(_mm_cmpgt_pd(ad, bd));
+         return true;
+      default:
+         break;
+      }
+      break;
+   }
+   return false;
+}
+
+bool ApplySse(Op op, Lane lane, uint8_t const* a, uint8_t const* b, uint8_t* out, size_t size) {
+   __m128i result;
+   if(size == 8) {
+      // the upper halves are zero, which no lane of the low half depends on
+      __m128i low_a = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(a));
+      __m128i low_b = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(b));
+      if(!SseBlock(op, lane, low_a, low_b, result)) {
+         return false;
+      }
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(out), result);
+      return true;
+   }
+   for(size_t i = 0; i < size; i += 16) {
+      __m128i block_a = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a + i));
+      __m128i block_b = _mm_loadu_si128(reinterpret_cast<__m128i const*>(b + i));
+      // whether there is an instruction does not depend on the block, so
+      // only the first can fail
+      if(!SseBlock(op, lane, block_a, block_b, result)) {
+         return false;
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), result);
+   }
+   return true;
+}
+#endif
+
+} // namespace
+
+void Apply(
+   Op op, Lane lane, std::span<uint8_t const> a, std::span<uint8_t const> b, std::span<uint8_t> out
+) {
+#if defined(__SSE2__)
+   if(ApplySse(op, lane, a.data(), b.data(), out.data(), a.size())) {
+      return;
+   }
+#endif
+   switch(lane) {
+   case Lane::kU8:
+      ScalarApply<uint8_t>(op, a.data(), b.data(), out.data(), a.size());
+      break;
+   case Lane::kI8:
+      ScalarApply<int8_t>(op, a.data(), b.data(), out.data(), a.size());
+      break;
+   case Lane::kU16:
+      ScalarApply<uint16_t>(op, a.data(), b.data(), out.data(), a.size());
+      break;
+   case Lane::kI16:
+      ScalarApply<int16_t>(op, a.data(), b.data(), out.data(), a.size());
+      break;
+   case Lane::kU32:
+      ScalarApply<uint32_t>(op, a.data(), b.data(), out.data(), a.size());
+      break;
+   case Lane::kI32:
+      ScalarApply<int32_t>(op, a.data(), b.data(), out.data(), a.size());
+      break;
+   case Lane::kU64:
+      ScalarApply<uint64_t>(op, a.data(), b.data(), out.data(), a.size());
+      break;
+   case Lane::kI64:
+      ScalarApply<int64_t>(op, a.data(), b.data(), out.data(), a.size());
+      break;
+   case Lane::kF32:
+      ScalarApply<float>(op, a.data(), b.data(), out.data(), a.size());
+      break;
+   case Lane::kF64:
+      ScalarApply<double>(op, a.data(), b.data(), out.data(), a.size());
+      break;
+   }
+}
+
+void ShuffleBytes(
+   std::span<uint8_t const> a, std::span<uint8_t const> control, std::span<uint8_t> out
+) {
+#if defined(__SSSE3__)
+   if(a.size() == 8) {
+      // with the upper half zero, three index bits pick from the low half
+      __m128i indices = _mm_and_si128(
+         _mm_loadl_epi64(reinterpret_cast<__m128i const*>(control.data())),
+         _mm_set1_epi8(static_cast<char>(0x87))
+      );
+      __m128i low = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(a.data()));
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(out.data()), _mm_shuffle_epi8(low, indices));
+      return;
+   }
+   for(size_t i = 0; i < a.size(); i += 16) {
+      __m128i block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a.data() + i));
+      __m128i indices = _mm_loadu_si128(reinterpret_cast<__m128i const*>(control.data() + i));
+      _mm_storeu_si128(
+         reinterpret_cast<__m128i*>(out.data() + i), _mm_shuffle_epi8(block, indices)
+      );
+   }
+#else
+   size_t index_mask = (a.size() == 8) ? 7 : 15;
+   std::array<uint8_t, kMaxVectorBytes> result{};
+   for(size_t i = 0; i < a.size(); ++i) {
+      size_t block = i & ~size_t{15};
+      uint8_t selector = control[i];
+      result[i] = ((selector & 0x80) != 0) ? 0 : a[block + (selector & index_mask)];
+   }
+   std::memcpy(out.data(), result.data(), a.size());
+#endif
+}
+
+void ShuffleDwords(std::span<uint8_t const> a, uint8_t order, std::span<uint8_t> out) {
+   // pshufd takes the order as an immediate, the same shuffle as pshufb
+   // controls works with one known at run time
+   std::array<uint8_t, kMaxVectorBytes> control{};
+   for(size_t i = 0; i < a.size(); ++i) {
+      size_t dword = (i / 4) % 4;
+      size_t source = (order >> (2 * dword)) & 3;
+      control[i] = static_cast<uint8_t>(source * 4 + i % 4);
+   }
+   ShuffleBytes(a, std::span(control.data(), a.size()), out);
+}
+
+} // namespace lanes
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+/// Lane-wise operations on 64, 128 and 256-bit vectors, with the semantics
+/// of the SSE instruction of the same name.
+///
+/// A vector is its bytes in memory order, lane 0 first. Operations on 256-bit
+/// vectors behave like their AVX2 forms, so shuffles stay within each 128-bit
+/// half. Each 16-byte block is done with one SSE instruction when the build
+/// targets an instruction set that has it, otherwise with a loop over the
+/// lanes that gives the same result.
+namespace lanes {
+
+enum class Lane : uint8_t { kU8, kI8, kU16, kI16, kU32, kI32, kU64, kI64, kF32, kF64 };
+
+inline constexpr size_t kMaxVectorBytes = 32;
+
+/// @brief 8, 16 or 32 bytes
+constexpr bool IsVectorSize(size_t bytes) {
+   return (bytes == 8) || (bytes == 16) || (bytes == 32);
+}
+
+constexpr size_t LaneBytes(Lane lane) {
+   switch(lane) {
+   case Lane::kU8:
+   case Lane::kI8:
+      return 1;
+   case Lane::kU16:
+   case Lane::kI16:
+      return 2;
+   case Lane::kU32:
+   case Lane::kI32:
+   case Lane::kF32:
+      return 4;
+   case Lane::kU64:
+   case Lane::kI64:
+   case Lane::kF64:
+      return 8;
+   }
+   return 1;
+}
+
+constexpr bool IsFloat(Lane lane) {
+   return (lane == Lane::kF32) || (lane == Lane::kF64);
+}
+
+constexpr bool IsSigned(Lane lane) {
+   switch(lane) {
+   case Lane::kI8:
+   case Lane::kI16:
+   case Lane::kI32:
+   case Lane::kI64:
+   case Lane::kF32:
+   case Lane::kF64:
+      return true;
+   default:
+      return false;
+   }
+}
+
+enum class Op {
+   /// @brief Wraps for ints
+   kAdd,
+   /// @brief Clamps ints to the range of the lane
+   kAddSaturate,
+   /// @brief a < b ? a : b, so b when either is NaN, like minps
+   kMin,
+   /// @brief a > b ? a : b, so b when either is NaN, like maxps
+   kMax,
+   /// @brief All ones where equal, zero elsewhere
+   kCompareEqual,
+   /// @brief All ones where a > b, zero elsewhere
+   kCompareGreater,
+};
+
+/// @brief out = a op b lane by lane. All three are the same vector size.
+void Apply(
+   Op op, Lane lane, std::span<uint8_t const> a, std::span<uint8_t const> b, std::span<uint8_t> out
+);
+
+/// @brief pshufb: byte i is zero if control byte i has its top bit set,
+/// otherwise the byte of its 16-byte block that the control's low four bits
+/// select, or low three bits for a 64-bit vector
+void ShuffleBytes(
+   std::span<uint8_t const> a, std::span<uint8_t const> control, std::span<uint8_t> out
+);
+
+/// @brief pshufd: dword j of each 16-byte block is the dword of that block
+/// that bits 2j and 2j+1 of order select. 128 and 256-bit vectors only.
+void ShuffleDwords(std::span<uint8_t const> a, uint8_t order, std::span<uint8_t> out);
+
+} // namespace lanes
@@ -1,9 +1,11 @@
 #include "calc/parse.hpp"
-#include "calc/math_util.hpp"
+#include "calc/bitset.hpp"
+#include "calc/builtins.hpp"
 #include "text.hpp"
 
 #include <cassert>
 #include <charconv>
+#include <format>
 #include <iostream>
 #include <limits>
 #include <optional>
@@ -70,17 +72,20 @@ struct Parser {
          return std::nullopt;
       }
 
+      auto name = remaining().substr(0, n_chars);
       auto tok = Token::make_error(current_index, current_index + n_chars, "undefined word");
-
-      for(size_t i = 0; i < settings.functions.size(); ++i) {
-         if(settings.functions[i]->name() == remaining().substr(0, n_chars)) {
-            tok = Token::make_word(
-               current_index,
-               current_index + n_chars,
-               i,
-               remaining().substr(0, n_chars)
-            );
-            break;
+      if(auto builtin = calc::FindBuiltin(name); builtin.has_value()) {
+         tok = Token::make_word(
+            current_index, current_index + n_chars, static_cast<size_t>(*builtin), name
+         );
+      } else {
+         for(size_t i = 0; i < settings.functions.size(); ++i) {
+            if(settings.functions[i]->name() == name) {
+               tok = Token::make_word(
+                  current_index, current_index + n_chars, calc::kBuiltinCount + i, name
+               );
+               break;
+            }
          }
       }
 
@@ -112,36 +117,29 @@ struct Parser {
          return std::nullopt;
       }
 
-      int64_t number = 0;
-      int64_t digit_mul = 1;
-      for(int i = n_chars - 1; i >= 0; --i) {
-         int64_t digit = base_chars.find(to_lower(remaining()[i]));
-         if(does_mul_overflow(digit, digit_mul)) {
-            auto tok = Token::make_error(current_index, current_index + n_chars, "overflow");
-            current_index += n_chars;
-            return tok;
-         }
-         if(does_add_overflow(number, digit * digit_mul)) {
-            auto tok = Token::make_error(current_index, current_index + n_chars, "overflow");
-            current_index += n_chars;
-            return tok;
-         }
-         number += digit * digit_mul;
-
-         if(does_mul_overflow(digit_mul, int_base)) {
+      // hex and binary are bit patterns, so they take all 64 bits. Decimal
+      // takes what an int64_t holds, down to its minimum when negated.
+      uint64_t limit = std::numeric_limits<uint64_t>::max();
+      if(base == intbase::IntBase::kDec) {
+         limit = static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + (negate ? 1 : 0);
+      }
+      uint64_t number = 0;
+      for(int i = 0; i < n_chars; ++i) {
+         uint64_t digit = base_chars.find(to_lower(remaining()[i]));
+         if(number > (limit - digit) / int_base) {
             auto tok = Token::make_error(current_index, current_index + n_chars, "overflow");
             current_index += n_chars;
             return tok;
          }
-         digit_mul *= int_base;
+         number = number * int_base + digit;
       }
 
       auto tok = Token::make_integer(
          current_index - (negate ? 1 : 0), // include minus sign
          current_index + n_chars,
          base,
-         // TODO overflow
-         negate ? -1 * number : number
+         // negating wraps, like the arithmetic words
+         static_cast<int64_t>(negate ? 0 - number : number)
       );
       current_index += n_chars;
       return tok;
@@ -216,18 +214,74 @@ struct Parser {
       }
    }
 
+   /// @brief `#` and pairs of hex digits, eg `#0aff` for the bytes 0a ff
+   std::optional<Token> bytes_literal() {
+      size_t start = current_index;
+      if(!prefix("#")) {
+         return std::nullopt;
+      }
+      int n_chars = how_many_numeric_chars(kNumericChars, 0);
+      current_index += n_chars;
+      if((n_chars % 2) != 0) {
+         return Token::make_error(start, current_index, "odd number of hex digits");
+      }
+      calc::Bytes bytes(n_chars / 2);
+      for(size_t i = 0; i < bytes.size(); ++i) {
+         auto high = kNumericChars.find(to_lower(input[start + 1 + i * 2]));
+         auto low = kNumericChars.find(to_lower(input[start + 2 + i * 2]));
+         bytes[i] = static_cast<uint8_t>((high << 4) | low);
+      }
+      return Token::make_bytes(start, current_index, std::move(bytes));
+   }
+
+   /// @brief A range list in braces, eg `{0-3,8-11,64}`, see bitset.hpp. The
+   /// indices are decimal whatever the input base.
+   std::optional<Token> bitset_literal() {
+      size_t start = current_index;
+      if(!prefix("{")) {
+         return std::nullopt;
+      }
+      size_t n_chars = 0;
+      while(((current_index + n_chars) < input.size()) && !IsWhitespace(remaining()[n_chars]) &&
+            (remaining()[n_chars] != '}')) {
+         ++n_chars;
+      }
+      auto list = input.substr(current_index, n_chars);
+      current_index += n_chars;
+      if(!prefix("}")) {
+         return Token::make_error(start, current_index, "missing }");
+      }
+      calc::BitWords words;
+      if(!bitset::ParseRangeList(list, words)) {
+         return Token::make_error(
+            start,
+            current_index,
+            std::format("invalid range list, bits are 0 to {}", bitset::kMaxBits - 1)
+         );
+      }
+      return Token::make_bitset(start, current_index, std::move(words));
+   }
+
    std::optional<Token> test_for_super_precedence(
       std::string_view c, size_t start, bool ignore_negation
    ) {
-      for(size_t i = 0; i < settings.functions.size(); ++i) {
+      for(auto builtin : calc::kSuperPrecedenceBuiltins) {
+         auto name = calc::Info(builtin).name;
          // negation parsing hack!
-         if(ignore_negation && settings.functions[i]->name() == "-") {
+         if(ignore_negation && (builtin == calc::Builtin::kSubtract)) {
             continue;
          }
+         if(c.starts_with(name)) {
+            return Token::make_word(start, start + name.size(), static_cast<size_t>(builtin), name);
+         }
+      }
+      for(size_t i = 0; i < settings.functions.size(); ++i) {
          if(settings.functions[i]->super_precedence()) {
-            auto const& name = settings.functions[i]->name();
-            if(c.rfind(name, 0) == 0) {
-               return Token::make_word(start, start + name.size(), i, c.substr(0, name.size()));
+            auto name = settings.functions[i]->name();
+            if(c.starts_with(name)) {
+               return Token::make_word(
+                  start, start + name.size(), calc::kBuiltinCount + i, name
+               );
             }
          }
       }
@@ -285,6 +339,14 @@ struct Parser {
       if(maybe.has_value()) {
          return *maybe;
       }
+      maybe = bytes_literal();
+      if(maybe.has_value()) {
+         return *maybe;
+      }
+      maybe = bitset_literal();
+      if(maybe.has_value()) {
+         return *maybe;
+      }
       maybe = string_literal();
       if(maybe.has_value()) {
          return *maybe;
@@ -329,6 +391,32 @@ void unit_test() {
          ->push_value.as_int() == 0b100101001110111010111011LL
    );
 
+   assert(
+      Parser("ffffffffffffffff", ParserSettings(intbase::IntBase::kDec, {}))
+         .number(intbase::IntBase::kHex)
+         ->push_value.as_int() == -1
+   );
+   assert(
+      Parser(std::string(64, '1'), ParserSettings(intbase::IntBase::kDec, {}))
+         .number(intbase::IntBase::kBin)
+         ->push_value.as_int() == -1
+   );
+   assert(
+      Parser("-9223372036854775808", ParserSettings(intbase::IntBase::kDec, {}))
+         .number(intbase::IntBase::kDec)
+         ->push_value.as_int() == std::numeric_limits<int64_t>::min()
+   );
+   assert(
+      Parser("10000000000000000", ParserSettings(intbase::IntBase::kDec, {}))
+         .number(intbase::IntBase::kHex)
+         ->type == TokenType::kError
+   );
+   assert(
+      Parser("9223372036854775808", ParserSettings(intbase::IntBase::kDec, {}))
+         .number(intbase::IntBase::kDec)
+         ->type == TokenType::kError
+   );
+
    auto settings = ParserSettings(intbase::IntBase::kDec, {});
    auto result = parse(settings, "123 0xff 0b1000 word*    3 4* 5 6<<>> abc//abc");
    for(auto token : result) {
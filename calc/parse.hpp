@@ -14,7 +14,17 @@
 
 namespace parse {
 
-enum class TokenType { kDecimalNumber, kHexNumber, kBinaryNumber, kDouble, kString, kWord, kError };
+enum class TokenType {
+   kDecimalNumber,
+   kHexNumber,
+   kBinaryNumber,
+   kDouble,
+   kString,
+   kBytes,
+   kBitset,
+   kWord,
+   kError
+};
 
 class Token {
 public:
@@ -41,6 +51,12 @@ public:
    static Token make_string(size_t start, size_t end, std::string n) {
       return Token(start, end, TokenType::kString, n, 0, "");
    }
+   static Token make_bytes(size_t start, size_t end, calc::Bytes n) {
+      return Token(start, end, TokenType::kBytes, calc::Value(std::move(n)), 0, "");
+   }
+   static Token make_bitset(size_t start, size_t end, calc::BitWords n) {
+      return Token(start, end, TokenType::kBitset, calc::Value(std::move(n)), 0, "");
+   }
    static Token make_word(size_t start, size_t end, int index, std::string_view word) {
       return Token(start, end, TokenType::kWord, calc::Value(int64_t{0}), index, std::string(word));
    }
@@ -97,6 +113,12 @@ public:
       case TokenType::kString:
          o << "string:\"" << tok.push_value.as_string() << "\"";
          break;
+      case TokenType::kBytes:
+         o << "bytes:" << tok.push_value.as_bytes().size();
+         break;
+      case TokenType::kBitset:
+         o << "bitset:" << tok.push_value.as_bitset().size();
+         break;
       case TokenType::kWord:
          o << "word:" << tok.text;
          break;
@@ -122,13 +144,20 @@ private:
 struct ParserSettings {
    ParserSettings(
       intbase::IntBase _default_numeric_base,
-      std::vector<std::unique_ptr<calc::Function>> const& _functions
+      calc::FunctionRegistry const& _functions
    ) :
       default_numeric_base(_default_numeric_base),
       functions(_functions) {}
 
    intbase::IntBase default_numeric_base;
-   std::vector<std::unique_ptr<calc::Function>> const& functions;
+   calc::FunctionRegistry const& functions;
+
+   /// @brief Identifies the settings for caching parse results. The
+   /// registry's generation changes whenever a word is added, replaced or
+   /// removed.
+   uint64_t hash() const {
+      return (static_cast<uint64_t>(default_numeric_base) << 56) ^ functions.generation();
+   }
 };
 
 std::vector<Token> parse(ParserSettings const& settings, std::string_view input);
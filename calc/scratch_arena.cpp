@@ -0,0 +1,21 @@
+#include "calc/scratch_arena.hpp"
+
+namespace calc {
+
+namespace {
+thread_local std::pmr::memory_resource* t_scratch = nullptr;
+} // namespace
+
+std::pmr::memory_resource* ScratchResource() {
+   return (t_scratch != nullptr) ? t_scratch : std::pmr::new_delete_resource();
+}
+
+ScopedScratch::ScopedScratch(std::pmr::memory_resource* resource) : m_previous(t_scratch) {
+   t_scratch = resource;
+}
+
+ScopedScratch::~ScopedScratch() {
+   t_scratch = m_previous;
+}
+
+} // namespace calc
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+
+namespace calc {
+
+/// @brief Bump allocator for memory that does not outlive one State::Execute,
+/// i.e. the arguments and results of each word. Values that end up on the
+/// stack are moved out of it as each word finishes.
+///
+/// Allocations come from one block allocated up front, so argument spans and
+/// results do not touch the heap. Freeing the newest allocation gives its
+/// space back, which is the usual order: a word's results are freed before
+/// its arguments. Anything else is only reclaimed by reset, which is O(1).
+///
+/// Past the capacity, allocations go to the heap and the arena is marked
+/// exhausted. Speculative execution stops there, which caps scratch memory
+/// only. Stack, string, byte and bitset storage stays on the heap and is
+/// limited by SpeculationBudget.
+class ScratchArena : public std::pmr::memory_resource {
+public:
+   explicit ScratchArena(size_t capacity) :
+      m_buffer(std::make_unique<std::byte[]>(capacity)),
+      m_capacity(capacity) {}
+
+   /// @brief Forget every allocation. Nothing allocated from the arena may be
+   /// used afterwards.
+   void reset() {
+      m_used = 0;
+      m_exhausted = false;
+   }
+
+   /// @brief True if an allocation did not fit since the last reset
+   bool exhausted() const {
+      return m_exhausted;
+   }
+
+   size_t used() const {
+      return m_used;
+   }
+
+private:
+   std::unique_ptr<std::byte[]> m_buffer;
+   size_t m_capacity;
+   size_t m_used = 0;
+   bool m_exhausted = false;
+
+   bool owns(std::byte const* ptr) const {
+      return (ptr >= m_buffer.get()) && (ptr < m_buffer.get() + m_capacity);
+   }
+
+   void* do_allocate(size_t bytes, size_t alignment) override {
+      auto base = reinterpret_cast<uintptr_t>(m_buffer.get());
+      size_t start = ((base + m_used + alignment - 1) & ~(alignment - 1)) - base;
+      if(start + bytes > m_capacity) {
+         m_exhausted = true;
+         return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+      }
+      m_used = start + bytes;
+      return m_buffer.get() + start;
+   }
+
+   void do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+      auto* start = static_cast<std::byte*>(ptr);
+      if(!owns(start)) {
+         std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+         return;
+      }
+      if(start + bytes == m_buffer.get() + m_used) {
+         m_used = static_cast<size_t>(start - m_buffer.get());
+      }
+   }
+
+   bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override {
+      return this == &other;
+   }
+};
+
+/// @brief Where function results are allocated on this thread: the arena of
+/// the State::Execute running on it, otherwise the heap
+std::pmr::memory_resource* ScratchResource();
+
+/// @brief Makes resource this thread's ScratchResource for its lifetime
+class ScopedScratch {
+public:
+   explicit ScopedScratch(std::pmr::memory_resource* resource);
+   ~ScopedScratch();
+   ScopedScratch(ScopedScratch const&) = delete;
+   ScopedScratch& operator=(ScopedScratch const&) = delete;
+
+private:
+   std::pmr::memory_resource* m_previous;
+};
+
+} // namespace calc
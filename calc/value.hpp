@@ -1,18 +1,38 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <span>
 #include <string>
+#include <string_view>
 #include <variant>
+#include <vector>
 
 namespace calc {
 
+using Bytes = std::vector<uint8_t>;
+/// @brief Byte buffers are immutable once made, so values share them
+using SharedBytes = std::shared_ptr<Bytes const>;
+/// @brief A bitset as 64-bit words, bit 0 first, without zero words at the
+/// end so equal sets have equal words. See bitset.hpp.
+using BitWords = std::vector<uint64_t>;
+/// @brief Shared like byte buffers
+using SharedBitWords = std::shared_ptr<BitWords const>;
+
 class Value {
 public:
-   enum class Type { kInt, kDouble, kString };
+   enum class Type { kInt, kDouble, kString, kBytes, kBitset };
+   static constexpr size_t kTypeCount = 5;
 
    Value(int64_t x) : inner(x), typ(Type::kInt) {}
    Value(double x) : inner(x), typ(Type::kDouble) {}
    Value(std::string x) : inner(x), typ(Type::kString) {}
+   Value(SharedBytes x) : inner(std::move(x)), typ(Type::kBytes) {}
+   Value(Bytes x) : Value(std::make_shared<Bytes const>(std::move(x))) {}
+   Value(SharedBitWords x) : inner(std::move(x)), typ(Type::kBitset) {}
+   Value(BitWords x) : Value(std::make_shared<BitWords const>(std::move(x))) {}
 
    Type type() const {
       return typ;
@@ -36,9 +56,70 @@ public:
       }
       return "";
    }
+   /// @brief Like as_string without the copy, valid while the value is
+   std::string_view as_string_view() const {
+      if(const std::string* pval = std::get_if<std::string>(&inner)) {
+         return *pval;
+      }
+      return "";
+   }
+
+   std::span<uint8_t const> as_bytes() const {
+      const SharedBytes* pval = std::get_if<SharedBytes>(&inner);
+      if((pval != nullptr) && (*pval != nullptr)) {
+         return **pval;
+      }
+      return {};
+   }
+
+   std::span<uint64_t const> as_bitset() const {
+      const SharedBitWords* pval = std::get_if<SharedBitWords>(&inner);
+      if((pval != nullptr) && (*pval != nullptr)) {
+         return **pval;
+      }
+      return {};
+   }
+
+   /// @brief The contents of a string or byte buffer, or the bytes of a
+   /// bitset's words, empty for numbers
+   std::span<uint8_t const> payload() const {
+      if(const std::string* pval = std::get_if<std::string>(&inner)) {
+         return std::span(reinterpret_cast<uint8_t const*>(pval->data()), pval->size());
+      }
+      if(typ == Type::kBitset) {
+         auto words = as_bitset();
+         return std::span(reinterpret_cast<uint8_t const*>(words.data()), words.size_bytes());
+      }
+      return as_bytes();
+   }
+
+   /// @brief Bytes a copy of the value allocates. Byte buffers and bitsets
+   /// are shared, so copying one allocates nothing.
+   size_t heap_bytes() const {
+      if(const std::string* pval = std::get_if<std::string>(&inner)) {
+         return pval->size();
+      }
+      return 0;
+   }
+
+   bool operator==(Value const& other) const {
+      if(typ != other.typ) {
+         return false;
+      }
+      if(typ == Type::kBytes) {
+         // the same buffer, or an equal one
+         return (std::get<SharedBytes>(inner) == std::get<SharedBytes>(other.inner)) ||
+                std::ranges::equal(as_bytes(), other.as_bytes());
+      }
+      if(typ == Type::kBitset) {
+         return (std::get<SharedBitWords>(inner) == std::get<SharedBitWords>(other.inner)) ||
+                std::ranges::equal(as_bitset(), other.as_bitset());
+      }
+      return inner == other.inner;
+   }
 
 private:
-   std::variant<int64_t, double, std::string> inner;
+   std::variant<int64_t, double, std::string, SharedBytes, SharedBitWords> inner;
    Type typ;
 };
 } // namespace calc
\ No newline at end of file
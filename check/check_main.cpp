@@ -0,0 +1,205 @@
+#include "calc/calc.hpp"
+#include "calc/parse.hpp"
+#include "controller.hpp"
+#include "history/HistoryStore.hpp"
+
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// @brief Prints what failed, returns the number of failures
+static int Expect(bool condition, std::string_view what) {
+   if(!condition) {
+      std::cerr << "FAILED: " << what << "\n";
+      return 1;
+   }
+   return 0;
+}
+
+static std::vector<std::string> Entries(HistoryStore const& history) {
+   std::vector<std::string> entries;
+   for(size_t i = 0; i < history.size(); ++i) {
+      entries.emplace_back(history[i]);
+   }
+   return entries;
+}
+
+/// @brief Entries written to the log, including ones that look like replace
+/// records, read back the same after replacing some of them
+static int CheckHistoryLogRoundTrip() {
+   auto path = (std::filesystem::temp_directory_path() / "claculator_check_history.log").string();
+   std::filesystem::remove(path);
+
+   std::vector<std::string> expected = {"1", "2", "~", "~0 +", "3", "~1", "~ 5"};
+   {
+      HistoryStore history;
+      if(!history.open_log(path)) {
+         std::cerr << "FAILED: cannot open " << path << "\n";
+         return 1;
+      }
+      for(auto const& entry : expected) {
+         history.push_back(entry);
+      }
+      history.replace(1, "~2 ~");
+      history.replace(4, "4");
+      expected[1] = "~2 ~";
+      expected[4] = "4";
+   }
+
+   HistoryStore reloaded;
+   reloaded.open_log(path);
+   int failures = Expect(Entries(reloaded) == expected, "history log round trip");
+   failures += Expect(
+      reloaded.find_before("~0", reloaded.size()) == size_t{3}, "search of a reloaded '~' entry"
+   );
+   std::filesystem::remove(path);
+   return failures;
+}
+
+static void Type(Controller& controller, std::string_view text) {
+   for(char c : text) {
+      controller.OnInputEvent(InputEvent::make_char(0, c));
+   }
+   controller.FlushPendingExecution();
+}
+
+static void Press(Controller& controller, KeyboardKey key) {
+   controller.OnInputEvent(InputEvent::make_key(0, key, KeyModifiers{.control = true}));
+   controller.FlushPendingExecution();
+}
+
+static void Commit(Controller& controller, std::string_view entry) {
+   Type(controller, entry);
+   Press(controller, KEY_ENTER);
+}
+
+/// @brief Replaces an entry the way the user does, which replays history from
+/// the checkpoint before it
+static void Edit(Controller& controller, size_t entry, std::string_view text) {
+   while(controller.history_highlighted_index > entry) {
+      Press(controller, KEY_K);
+   }
+   while(controller.history_highlighted_index < entry) {
+      Press(controller, KEY_J);
+   }
+   Press(controller, KEY_E);
+   Press(controller, KEY_D);
+   Commit(controller, text);
+}
+
+static bool SameState(calc::Context const& a, calc::Context const& b) {
+   return (a.stack().data == b.stack().data) && (a.reg().fields == b.reg().fields) &&
+      (a.variables() == b.variables());
+}
+
+/// @brief The replayed state after every entry is the state of executing all
+/// entries again from scratch
+static int ExpectReplayMatches(Controller const& controller, std::string_view what) {
+   calc::State scratch;
+   for(size_t i = 0; i < controller.history.size(); ++i) {
+      auto tokens = parse::parse(
+         parse::ParserSettings(intbase::IntBase::kDec, scratch.functions), controller.history[i]
+      );
+      scratch.Execute(tokens, false);
+      scratch.Commit();
+      if(!SameState(controller.live_history.before(i + 1), scratch.committed)) {
+         std::cerr << "FAILED: " << what << ", after entry " << i << " \""
+                   << controller.history[i] << "\"\n";
+         return 1;
+      }
+   }
+   return Expect(SameState(controller.state.committed, scratch.committed), what);
+}
+
+/// @brief Editing an entry in live history mode gives the state of running
+/// the edited history from scratch, both when the replay stops early because
+/// the edit changes nothing later entries read and when it does not
+static int CheckLiveHistoryReplay() {
+   int failures = 0;
+   {
+      Controller controller;
+      Press(controller, KEY_G);
+      for(auto entry : {"1 2", "3", "+", "\"x store", "dup", "4 *", "swap", "drop", "\"x load"}) {
+         Commit(controller, entry);
+      }
+      // same result, the replay stops after the edited entry
+      Edit(controller, 1, "1 2 +");
+      failures += ExpectReplayMatches(controller, "edit with the same result");
+      // only the value below what later entries read changes
+      Edit(controller, 0, "1 9");
+      failures += ExpectReplayMatches(controller, "edit below the values read");
+      // changes what later entries read
+      Edit(controller, 2, "*");
+      failures += ExpectReplayMatches(controller, "edit of a value that is read");
+      // changes a variable that a later entry loads
+      Edit(controller, 3, "\"x store 5 \"x store");
+      failures += ExpectReplayMatches(controller, "edit of a variable");
+      // changes the stack depth
+      Edit(controller, 5, "4 * 7");
+      failures += ExpectReplayMatches(controller, "edit that pushes more");
+   }
+
+   static constexpr char const* kEntries[] = {
+      "+", "-", "*", "dup", "drop", "swap", "1", "2", "3", "dup +", "swap -", "drop drop",
+      "5 6", "\"ab\"", "\"x store", "\"x load", "0 3 \"f field", "clearfields", "\"y load",
+   };
+   std::mt19937 rng(7);
+   auto random_entry = [&] {
+      std::string entry = kEntries[rng() % std::size(kEntries)];
+      if(rng() % 3 == 0) {
+         entry += ' ';
+         entry += kEntries[rng() % std::size(kEntries)];
+      }
+      return entry;
+   };
+   // several checkpoints, the last one after the newest entry
+   static constexpr size_t kRandomEntries = 3 * LiveHistory::kCheckpointInterval;
+   for(int round = 0; round < 4; ++round) {
+      Controller controller;
+      Press(controller, KEY_G);
+      for(size_t i = 0; i < kRandomEntries; ++i) {
+         Commit(controller, random_entry());
+      }
+      for(int edit = 0; edit < 20; ++edit) {
+         Edit(controller, rng() % controller.history.size(), random_entry());
+         if(ExpectReplayMatches(controller, "random edit") > 0) {
+            return failures + 1;
+         }
+      }
+   }
+   return failures;
+}
+
+static bool Deferred(std::string_view input) {
+   calc::State state;
+   auto tokens =
+      parse::parse(parse::ParserSettings(intbase::IntBase::kDec, state.functions), input);
+   state.Execute(tokens, true);
+   return state.speculation_deferred;
+}
+
+/// @brief Repeating a string counts the repeats against the speculation
+/// budget, even when the string is empty and the result is too
+static int CheckRepeatCost() {
+   int failures = Expect(!Deferred("\"ab 3 *"), "short repeat runs speculatively");
+   failures += Expect(Deferred("\" 100000000000 *"), "huge repeat of \"\" is deferred");
+   failures += Expect(Deferred("100000000000 \" *"), "huge repeat, count first, is deferred");
+   failures += Expect(Deferred("\"ab 100000000 *"), "huge repeat of \"ab\" is deferred");
+   return failures;
+}
+
+int main() {
+   int failures = 0;
+   failures += CheckHistoryLogRoundTrip();
+   failures += CheckLiveHistoryReplay();
+   failures += CheckRepeatCost();
+   if(failures > 0) {
+      std::cerr << failures << " checks failed\n";
+      return 1;
+   }
+   std::cout << "all checks passed\n";
+   return 0;
+}
@@ -1,76 +1,60 @@
 #include "controller.hpp"
+#include "calc/bit_ops.hpp"
+#include "calc/bitset.hpp"
+#include "calc/byte_codec.hpp"
+#include "calc/int_format.hpp"
 #include "calc/parse.hpp"
+#include "perf/alloc_tracker.hpp"
+#include "perf/profiler.hpp"
 #include "text.hpp"
 
-#include <array>
-#include <charconv>
+#include <algorithm>
 #include <format>
+#include <fstream>
 #include <iostream>
 #include <memory>
 
-class FieldFunction : public calc::BuiltinNormalFunction {
+class DumpTraceFunction : public calc::BuiltinNormalFunction {
 public:
-   FieldFunction(Controller& controller) :
-      calc::BuiltinNormalFunction(3, "field"),
-      m_controller(controller) {}
+   DumpTraceFunction() : calc::BuiltinNormalFunction(0, "dumptrace") {}
    bool allow_speculative_execution() const override {
       return false;
    }
-   ExecutionResult execute(std::vector<calc::Value> input) override {
-      if((input[0].type() != calc::Value::Type::kInt) ||
-         (input[1].type() != calc::Value::Type::kInt) ||
-         (input[2].type() != calc::Value::Type::kString)) {
-         return ExecutionResult::make_error("require (int int string)");
+   ExecutionResult execute(std::span<calc::Value> input) override {
+      static constexpr char const* kTracePath = "claculator_trace.json";
+      std::ofstream file(kTracePath);
+      if(!file) {
+         return ExecutionResult::make_error(std::format("cannot write {}", kTracePath));
       }
-
-      for(auto const& field : m_controller.current_register.fields) {
-         if(field.name == input[2].as_string()) {
-            // an identical field already exists
-            return ExecutionResult::make_success();
-         }
-      }
-
-      m_controller.current_register.fields.push_back(
-         Field(input[0].as_int(), input[1].as_int(), input[2].as_string(), FieldDisplay::kNumeric)
-      );
-
-      for(auto const& field : m_controller.current_register.fields) {
-         std::cout << field.name << "\n";
-      }
-
+      profiler::Profiler::get().write_chrome_trace(file);
       return ExecutionResult::make_success();
    }
-
-private:
-   Controller& m_controller;
-};
-
-class ClearFieldsFunction : public calc::BuiltinNormalFunction {
-public:
-   ClearFieldsFunction(Controller& controller) :
-      calc::BuiltinNormalFunction(0, "clearfields"),
-      m_controller(controller) {}
-   bool allow_speculative_execution() const override {
-      return false;
-   }
-   ExecutionResult execute(std::vector<calc::Value> input) override {
-      m_controller.current_register.fields.clear();
-      return ExecutionResult::make_success();
-   }
-
-private:
-   Controller& m_controller;
 };
 
 Controller::Controller() {
-   state.functions.push_back(std::make_unique<FieldFunction>(*this));
-   state.functions.push_back(std::make_unique<ClearFieldsFunction>(*this));
+   state.functions.push_back(std::make_unique<DumpTraceFunction>());
+}
+
+static constexpr bool IsInsertableChar(int chr) {
+   return (chr >= 32) && (chr <= 126);
 }
 
+// history entries are made of insertable characters, anything else is free to
+// mark records in the history log
+static_assert(!IsInsertableChar(HistoryStore::kReplaceMarker));
+
 void Controller::OnCharPressed(int chr) {
+   if(history_search.active) {
+      if(IsInsertableChar(chr)) {
+         history_search.query.push_back(static_cast<char>(chr));
+         ++revisions.search;
+         UpdateHistorySearch(history.size());
+      }
+      return;
+   }
    switch(editor_mode.mode) {
    case EditorMode::Mode::kInsert:
-      if((chr >= 32) && (chr <= 125)) {
+      if(IsInsertableChar(chr)) {
          // current_input.push_back(static_cast<char>(chr));
          if(highlighted_index >= current_input.size()) {
             current_input.append(1, static_cast<char>(chr));
@@ -78,7 +62,16 @@ void Controller::OnCharPressed(int chr) {
             current_input.insert(highlighted_index, 1, static_cast<char>(chr));
          }
          ++highlighted_index;
-         SpeculativelyExecuteInput(true, true);
+         if(fast_entry_mode.mode == FastEntryMode::Mode::kOn) {
+            // eager entry has to look at every prefix of the input to decide
+            // whether to commit, so it cannot be batched. This also covers any
+            // edits still pending.
+            m_execution_pending = false;
+            m_pending_reset_history_highlight = false;
+            SpeculativelyExecuteInput(true, true);
+         } else {
+            RequestExecution(true);
+         }
       }
       break;
    default:
@@ -86,11 +79,44 @@ void Controller::OnCharPressed(int chr) {
    }
 }
 
+void Controller::InsertText(std::string_view text) {
+   std::string filtered;
+   filtered.reserve(text.size());
+   for(char c : text) {
+      if(IsWhitespace(c)) {
+         filtered.push_back(' ');
+      } else if(IsInsertableChar(c)) {
+         filtered.push_back(c);
+      }
+   }
+   if(filtered.empty()) {
+      return;
+   }
+
+   highlighted_index = std::min(highlighted_index, current_input.size());
+   current_input.insert(highlighted_index, filtered);
+   highlighted_index += filtered.size();
+   RequestExecution(true);
+}
+
+void Controller::RequestExecution(bool reset_history_highlight) {
+   m_execution_pending = true;
+   m_pending_reset_history_highlight |= reset_history_highlight;
+}
+
+void Controller::FlushPendingExecution() {
+   if(m_execution_pending) {
+      m_execution_pending = false;
+      SpeculativelyExecuteInput(m_pending_reset_history_highlight, false);
+      m_pending_reset_history_highlight = false;
+   }
+}
+
 void Controller::OnHistoryHighlightChanged() {
    if(history_highlighted_index < history.size()) {
-      current_input = history[history_highlighted_index];
+      current_input.assign(history[history_highlighted_index]);
       highlighted_index = current_input.size();
-      SpeculativelyExecuteInput(false, false);
+      RequestExecution(false);
    }
 }
 
@@ -103,14 +129,100 @@ template <typename T> T RotateEnum(T value, T max) {
    return static_cast<T>(new_value);
 }
 
-void Controller::OnKeyPressed(KeyboardKey k) {
+void Controller::OnInputEvent(InputEvent const& event) {
+   switch(event.type) {
+   case InputEvent::Type::kChar:
+      OnCharPressed(event.code);
+      break;
+   case InputEvent::Type::kKey:
+      OnKeyPressed(static_cast<KeyboardKey>(event.code), event.modifiers);
+      break;
+   case InputEvent::Type::kPaste:
+      InsertText(event.text);
+      break;
+   }
+}
+
+static bool IsModifierKey(KeyboardKey k) {
+   return (k >= KEY_LEFT_SHIFT) && (k <= KEY_RIGHT_SUPER);
+}
+
+void Controller::UpdateHistorySearch(size_t before) {
+   auto match = history.find_before(history_search.query, before);
+   history_search.found = match.has_value();
+   ++revisions.search;
+   if(match.has_value() && (*match != history_highlighted_index)) {
+      history_highlighted_index = *match;
+      ++revisions.history;
+      OnHistoryHighlightChanged();
+   }
+}
+
+void Controller::EndHistorySearch(bool accept) {
+   history_search.active = false;
+   ++revisions.search;
+   if(!accept) {
+      current_input = std::move(history_search.saved_input);
+      highlighted_index = current_input.size();
+      RequestExecution(true);
+   }
+   history_search.query.clear();
+   history_search.saved_input.clear();
+}
+
+bool Controller::OnHistorySearchKey(KeyboardKey k, KeyModifiers modifiers) {
+   if(modifiers.control && (k == KEY_R)) {
+      // step to the next older match, or stay put if there is none
+      UpdateHistorySearch(history_search.found ? history_highlighted_index : history.size());
+      return true;
+   }
+   if((k == KEY_ESCAPE) || (modifiers.control && (k == KEY_G))) {
+      EndHistorySearch(false);
+      return true;
+   }
+   if(k == KEY_BACKSPACE) {
+      if(!history_search.query.empty()) {
+         history_search.query.pop_back();
+         ++revisions.search;
+         UpdateHistorySearch(history.size());
+      }
+      return true;
+   }
+   // typed characters arrive as char events too, and modifiers on their own
+   // are pressed while reaching for Ctrl+R
+   bool printable = (k >= KEY_SPACE) && (k <= KEY_GRAVE);
+   if(IsModifierKey(k) || (printable && !modifiers.control)) {
+      return true;
+   }
+   // anything else keeps the match and then acts as usual, so Enter commits it
+   EndHistorySearch(true);
+   return false;
+}
+
+void Controller::OnKeyPressed(KeyboardKey k, KeyModifiers modifiers) {
+   if(history_search.active && OnHistorySearchKey(k, modifiers)) {
+      return;
+   }
+   if(modifiers.control && (k == KEY_R)) {
+      history_search.active = true;
+      history_search.found = true;
+      history_search.saved_input = current_input;
+      ++revisions.search;
+      return;
+   }
+
    if(k == KEY_ENTER) {
       OnCommit();
       return;
    }
+   if((k == KEY_ESCAPE) && editing_entry.has_value()) {
+      editing_entry.reset();
+      ++revisions.history;
+      RequestExecution(true);
+      return;
+   }
 
-   if((editor_mode.mode == EditorMode::Mode::kNormal) || IsKeyDown(KEY_LEFT_CONTROL) ||
-      IsKeyDown(KEY_RIGHT_CONTROL)) {
+   if((editor_mode.mode == EditorMode::Mode::kNormal) || modifiers.control) {
       switch(k) {
       case KEY_H:
          if(highlighted_index > 0) {
@@ -124,21 +236,26 @@ void Controller::OnKeyPressed(KeyboardKey k) {
          break;
       case KEY_I:
          editor_mode.mode = EditorMode::Mode::kInsert;
+         ++revisions.modes;
          break;
       case KEY_J:
+         editing_entry.reset();
          if(history_highlighted_index < history.size()) {
             ++history_highlighted_index;
          }
+         ++revisions.history;
          OnHistoryHighlightChanged();
          break;
       case KEY_K:
+         editing_entry.reset();
          if(history_highlighted_index > 0) {
             --history_highlighted_index;
          }
+         ++revisions.history;
          OnHistoryHighlightChanged();
          break;
       case KEY_A:
-         if(IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT)) {
+         if(modifiers.shift) {
             highlighted_index = current_input.size();
          } else {
             if(highlighted_index <= current_input.size()) {
@@ -146,30 +263,72 @@ void Controller::OnKeyPressed(KeyboardKey k) {
             }
          }
          editor_mode.mode = EditorMode::Mode::kInsert;
+         ++revisions.modes;
          break;
       case KEY_D:
          current_input.clear();
          highlighted_index = 0;
-         SpeculativelyExecuteInput(true, false);
+         RequestExecution(true);
          break;
       case KEY_Z:
          input_display.Rotate();
-         SpeculativelyExecuteInput(true, false);
+         ++revisions.modes;
+         RequestExecution(true);
          break;
       case KEY_X:
          output_display.Rotate();
+         ++revisions.modes;
          break;
       case KEY_S:
          sep_mode.Rotate();
+         ++revisions.modes;
          break;
       case KEY_W:
          int_width.Rotate();
+         ApplyIntWidth();
+         ++revisions.modes;
+         break;
+      case KEY_V:
+         lane_view.Rotate();
+         ++revisions.modes;
          break;
       case KEY_R:
          fix_mode.Rotate();
+         ++revisions.modes;
          break;
       case KEY_F:
          fast_entry_mode.Rotate();
+         ++revisions.modes;
+         break;
+      case KEY_P:
+         show_profiler_overlay = !show_profiler_overlay;
+         break;
+      case KEY_G:
+         live_history_mode.Rotate();
+         SetLiveHistory(live_history_mode.mode == LiveHistoryMode::Mode::kOn);
+         ++revisions.modes;
+         ++revisions.history;
+         break;
+      case KEY_Q:
+         if(modifiers.shift) {
+            RemoveNewestWatch();
+         } else if(!current_input.empty()) {
+            AddWatch(current_input);
+            current_input.clear();
+            highlighted_index = 0;
+            RequestExecution(true);
+         }
+         break;
+      case KEY_E:
+         if(live_history.contains(history_highlighted_index)) {
+            editing_entry = history_highlighted_index;
+            m_edit_base = live_history.before(history_highlighted_index);
+            // the edit runs at the current width, not the one it was entered at
+            m_edit_base.set_int_width(int_width.ToBits());
+            editor_mode.mode = EditorMode::Mode::kInsert;
+            ++revisions.modes;
+            ++revisions.history;
+         }
          break;
       default:
          break;
@@ -180,7 +339,7 @@ void Controller::OnKeyPressed(KeyboardKey k) {
       switch(k) {
       case KEY_BACKSPACE:
          if(!current_input.empty()) {
-            if(IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL)) {
+            if(modifiers.control) {
                // delete non-whitespace
                while((highlighted_index > 0) && !IsWhitespace(current_input[highlighted_index - 1])
                ) {
@@ -191,15 +350,16 @@ void Controller::OnKeyPressed(KeyboardKey k) {
                ) {
                   DeleteOneChar();
                }
-               SpeculativelyExecuteInput(true, false);
+               RequestExecution(true);
             } else {
                DeleteOneChar();
-               SpeculativelyExecuteInput(true, false);
+               RequestExecution(true);
             }
          }
          break;
       case KEY_CAPS_LOCK:
          editor_mode.mode = EditorMode::Mode::kNormal;
+         ++revisions.modes;
          break;
       default:
          break;
@@ -216,38 +376,53 @@ void Controller::DeleteOneChar() {
 }
 
 std::string Controller::GetStackDisplayStringRadix(int index, NumericDisplayMode::Mode mode) {
-   if(state.speculative_stack.data.empty()) {
+   PROFILE_ZONE("GetStackDisplayString");
+   ALLOC_PHASE(alloc_tracker::Phase::kFormat);
+   auto const& stack = state.speculative.stack().data;
+   if(stack.empty()) {
       return "";
    }
+   return FormatValue(stack[index], mode);
+}
 
-   calc::Value const& item = state.speculative_stack.data[index];
+std::string Controller::FormatValue(calc::Value const& item, NumericDisplayMode::Mode mode) {
    switch(item.type()) {
    case calc::Value::Type::kInt: {
-      std::array<char, 33> buf{};
-      int base = intbase::as_int(mode);
-      std::to_chars(
-         &*buf.begin(),
-         (&*buf.begin()) + buf.size(),
-         state.speculative_stack.data[index].as_int(),
-         base
-      );
-      auto str = std::string(&*buf.begin());
-      if(sep_mode.mode != SeparatorMode::Mode::kNone) {
-         int skipped = 1;
-         for(int i = str.size() - 1; i > 0; --i) {
-            if(skipped == sep_mode.ToNumDigits()) {
-               str.insert(i, 1, ',');
-               skipped = 0;
-            }
-            ++skipped;
-         }
-      }
-      return str;
-   }; break;
+      // Arithmetic wraps at 64 bits, so a value can be wider than the width.
+      // Decimal always shows the whole value. Hex and binary show the bit
+      // pattern at the width if the width holds the value as signed or
+      // unsigned, otherwise the whole value too, so no base hides high bits.
+      int64_t value = item.as_int();
+      auto radix = intformat::FromIntBase(mode);
+      int width = int_width.ToBits();
+      auto bits = static_cast<uint64_t>(value);
+      bool fits = (bitops::SignExtend(bits, width) == value) || ((bits >> (width - 1) >> 1) == 0);
+      intformat::Options options{
+         .radix = radix,
+         .width = ((radix != intformat::Radix::kDec) && fits) ? width : 64,
+         .group = sep_mode.ToNumDigits(),
+         .separator = ',',
+      };
+      return intformat::FormatToString(value, options);
+   }
    case calc::Value::Type::kDouble:
       return std::format("{}", item.as_double());
    case calc::Value::Type::kString:
       return std::format("\"{}\"", item.as_string());
+   case calc::Value::Type::kBytes: {
+      // long buffers are cut short, they are redrawn every frame
+      auto bytes = item.as_bytes();
+      if(bytes.size() <= kMaxDisplayedBytes) {
+         return "#" + bytecodec::EncodeHex(bytes);
+      }
+      return std::format(
+         "#{}... ({} bytes)",
+         bytecodec::EncodeHex(bytes.first(kMaxDisplayedBytes)),
+         bytes.size()
+      );
+   }
+   case calc::Value::Type::kBitset:
+      return "{" + bitset::FormatRangeList(item.as_bitset(), kMaxDisplayedRuns) + "}";
    default:
       return "";
    }
@@ -258,11 +433,24 @@ std::string Controller::GetStackDisplayString(int index) {
 }
 
 void Controller::ParseInput() {
+   PROFILE_ZONE("ParseInput");
+   ALLOC_PHASE(alloc_tracker::Phase::kParse);
    parsed = parse::parse(parse::ParserSettings(input_display.mode, state.functions), current_input);
 }
 
 void Controller::SpeculativelyExecuteInput(bool reset_history_highlight, bool allow_fast_entry) {
-   ParseInput();
+   auto settings_hash = parse::ParserSettings(input_display.mode, state.functions).hash();
+   // an edited entry runs against the state before it, which the cache key
+   // does not describe
+   auto const* cached =
+      editing_entry.has_value()
+         ? nullptr
+         : m_execution_cache.find(current_input, settings_hash, state.committed_version);
+   if(cached != nullptr) {
+      parsed = cached->tokens;
+   } else {
+      ParseInput();
+   }
 
    // If we are not selecting history:
    // If fast entry mode is enabled and the input is all ok (speculative etc):
@@ -279,8 +467,7 @@ void Controller::SpeculativelyExecuteInput(bool reset_history_highlight, bool al
             break;
          }
          if((token.type == parse::TokenType::kWord)) {
-            auto& function = state.functions[parsed.back().function_index];
-            if(!function->allow_speculative_execution()) {
+            if(!state.AllowsSpeculativeExecution(token.function_index)) {
                ok_to_fast_commit = false;
                break;
             }
@@ -292,22 +479,298 @@ void Controller::SpeculativelyExecuteInput(bool reset_history_highlight, bool al
       }
    }
 
-   state.Execute(parsed, true);
-   if(reset_history_highlight) {
+   if(cached != nullptr) {
+      state.speculative = cached->speculative;
+      state.speculate_poisoned = cached->speculate_poisoned;
+   } else if(editing_entry.has_value()) {
+      state.Execute(m_edit_base, parsed, true);
+   } else {
+      state.Execute(parsed, true);
+      // a deferral may be down to the time budget, which another run can meet
+      if(!state.speculation_deferred) {
+         m_execution_cache.insert(
+            current_input,
+            settings_hash,
+            state.committed_version,
+            calc::CachedExecution{parsed, state.speculative, state.speculate_poisoned}
+         );
+      }
+   }
+   ++revisions.input;
+   ++revisions.stack;
+   if(reset_history_highlight && (history_highlighted_index != history.size())) {
       history_highlighted_index = history.size();
+      ++revisions.history;
+   }
+}
+
+void Controller::RequestHistoryPreviews(size_t first, size_t last) {
+   PreviewRequestKey key{
+      .committed_version = state.committed_version,
+      .base = input_display.mode,
+      .first = first,
+      .last = std::min(last, history.size()),
+      .history_size = history.size(),
+   };
+   if(key == m_preview_request) {
+      return;
+   }
+   if((key.committed_version != m_preview_request.committed_version) ||
+      (key.base != m_preview_request.base)) {
+      history_previews.set_checkpoint(state.committed_version, state.committed, key.base);
+   }
+   m_preview_request = key;
+
+   // newest first, the bottom of the list is what was typed most recently
+   std::vector<PreviewWorker::Request> rows;
+   for(size_t i = key.last; i > key.first; --i) {
+      rows.push_back(PreviewWorker::Request{i - 1, std::string(history[i - 1])});
+   }
+   history_previews.request(std::move(rows));
+}
+
+void Controller::UpdateWatches() {
+   // a poisoned speculation stopped partway, its stack is not worth watching
+   if(watches.empty() || (revisions.stack == m_watched_stack_revision) ||
+      state.speculate_poisoned) {
+      return;
+   }
+   m_watched_stack_revision = revisions.stack;
+   watch_worker.set_context(state.speculative, input_display.mode);
+}
+
+void Controller::AddWatch(std::string_view input) {
+   Watch watch{.id = m_next_watch_id++, .name = std::string(input), .expression = ""};
+   auto tokens = parse::parse(parse::ParserSettings(input_display.mode, state.functions), input);
+   if(!tokens.empty() && (tokens.front().type == parse::TokenType::kString)) {
+      watch.name = tokens.front().push_value.as_string();
+      input.remove_prefix(std::min(tokens.front().span.end + 1, input.size()));
+   }
+   watch.expression = std::string(input);
+   if(watches.empty()) {
+      // the worker has no stack to evaluate against yet
+      m_watched_stack_revision = ~0ull;
+      UpdateWatches();
+   }
+   watch_worker.add(watch);
+   watches.push_back(std::move(watch));
+   ++revisions.watches;
+}
+
+void Controller::RemoveNewestWatch() {
+   if(watches.empty()) {
+      return;
    }
+   watch_worker.remove(watches.back().id);
+   watches.pop_back();
+   ++revisions.watches;
+}
+
+void Controller::ApplyIntWidth() {
+   // words compute differently at the new width, so the committed state is a
+   // new version and everything cached against the old one is recomputed
+   state.committed.set_int_width(int_width.ToBits());
+   m_edit_base.set_int_width(int_width.ToBits());
+   ++state.committed_version;
+   RequestExecution(false);
+}
+
+void Controller::OnSessionRestored() {
+   state.committed.set_int_width(int_width.ToBits());
+   state.speculative = state.committed;
+   state.speculate_poisoned = false;
+   ++state.committed_version;
+   history_highlighted_index = history.size();
+   ++revisions.input;
+   ++revisions.stack;
+   ++revisions.history;
+   ++revisions.modes;
+   ++revisions.reg;
 }
 
 void Controller::OnCommit() {
+   FlushPendingExecution();
+   if(editing_entry.has_value()) {
+      CommitHistoryEdit();
+      return;
+   }
    if(current_input.empty()) {
       return;
    }
+   size_t size_before = state.committed.stack().data.size();
    state.Execute(parsed, false);
    state.Commit();
-   if(history.empty() || (history.back() != current_input)) {
+   // live history needs one entry per commit to line up with its steps
+   if(live_history.active() || history.empty() || (history.back() != current_input)) {
       history.push_back(current_input);
    }
+   if(live_history.active()) {
+      live_history.record(LiveHistory::MakeStep(state, size_before, input_display.mode));
+   }
+   current_input.clear();
+   parsed.clear();
+   highlighted_index = 0;
+   history_highlighted_index = history.size();
+   ++revisions.input;
+   ++revisions.stack;
+   ++revisions.history;
+   ++revisions.reg;
+}
+
+void Controller::SetLiveHistory(bool on) {
+   editing_entry.reset();
+   if(on) {
+      // entries committed before now have no recorded steps and stay read-only
+      live_history.start(history.size(), state.committed);
+   } else {
+      live_history.stop();
+   }
+}
+
+void Controller::CommitHistoryEdit() {
+   size_t entry = *editing_entry;
+   editing_entry.reset();
+   m_edit_base = calc::Context{};
+   if(!current_input.empty() && (history[entry] != current_input)) {
+      history.replace(entry, current_input);
+      ReplayHistoryFrom(entry);
+   }
    current_input.clear();
+   parsed.clear();
    highlighted_index = 0;
    history_highlighted_index = history.size();
-}
\ No newline at end of file
+   RequestExecution(false);
+   ++revisions.input;
+   ++revisions.stack;
+   ++revisions.history;
+   ++revisions.reg;
+}
+
+namespace {
+/// @brief How a replayed stack compares to the recorded one at the same entry
+struct Divergence {
+   /// @brief Number of values from the top that are known to be equal
+   size_t equal_top = 0;
+
+   bool equal(calc::Stack const& now, calc::Stack const& old) const {
+      return (now.data.size() == old.data.size()) && (equal_top >= now.data.size());
+   }
+
+   /// @brief True if the step reads the same values from both stacks
+   bool unchanged_for(
+      LiveHistory::Step const& step, calc::Stack const& now, calc::Stack const& old
+   ) const {
+      return step.reads_all ? equal(now, old) : (step.reads <= equal_top);
+   }
+
+   /// @brief Update after both stacks had the same step applied
+   void skip(LiveHistory::Step const& step) {
+      equal_top = equal_top - step.reads + step.pushed.size();
+   }
+
+   /// @brief Update after an entry was rerun. Below the values each run
+   /// popped, the stacks are what they were before, so the comparison stops
+   /// there if they line up the same way and the old count still holds.
+   void rerun(
+      calc::Stack const& now,
+      size_t now_kept,
+      calc::Stack const& old,
+      size_t old_kept,
+      size_t now_size_before,
+      size_t old_size_before
+   ) {
+      size_t now_size = now.data.size();
+      size_t old_size = old.data.size();
+      bool aligned = (now_size - now_size_before) == (old_size - old_size_before);
+      size_t count = 0;
+      while((count < now_size) && (count < old_size)) {
+         size_t now_index = now_size - 1 - count;
+         size_t old_index = old_size - 1 - count;
+         if(aligned && (now_index < now_kept) && (old_index < old_kept)) {
+            size_t depth = now_size_before - now_index;
+            count += (equal_top >= depth) ? equal_top - depth + 1 : 0;
+            break;
+         }
+         if(now.data[now_index] != old.data[old_index]) {
+            break;
+         }
+         ++count;
+      }
+      equal_top = count;
+   }
+};
+} // namespace
+
+/// @brief True if the register layout and variables are the same, cheap
+/// when neither was copied since
+static bool SameRegisterAndVariables(calc::Context const& now, LiveHistory::Step const& old) {
+   bool same_reg = (now.shared_reg() == old.reg) || (now.reg().fields == old.reg->fields);
+   return same_reg &&
+      ((now.shared_variables() == old.variables) || (now.variables() == *old.variables));
+}
+
+void Controller::ReplayHistoryFrom(size_t entry) {
+   PROFILE_ZONE("ReplayHistoryFrom");
+   // The replay walks the new states and the recorded ones side by side. An
+   // entry that only reads values both have in common produces its recorded
+   // step again, so the step is applied without executing the entry.
+   calc::Context context = live_history.before(entry);
+   calc::Stack old_stack = context.stack();
+   bool context_differs = false;
+   Divergence divergence{.equal_top = old_stack.data.size()};
+
+   size_t end = live_history.end();
+   for(size_t i = entry; i < end; ++i) {
+      if((i > entry) && !context_differs && divergence.equal(context.stack(), old_stack)) {
+         // every entry from here on runs on the state it ran on before, so
+         // its step and the committed state are still what was recorded
+         state.speculative = state.committed;
+         ++state.committed_version;
+         return;
+      }
+      live_history.update_checkpoint(i, context.stack());
+      auto const& old_step = live_history.step(i);
+      bool rerun = (i == entry) || context_differs ||
+         !divergence.unchanged_for(old_step, context.stack(), old_stack);
+      if(!rerun) {
+         LiveHistory::Apply(old_step, context.edit_stack());
+         LiveHistory::Apply(old_step, old_stack);
+         divergence.skip(old_step);
+         context.set_shared_reg(old_step.reg);
+         context.set_shared_variables(old_step.variables);
+         continue;
+      }
+
+      // the edited entry is parsed with the current mode, the others the way
+      // they were first entered
+      auto base = (i == entry) ? input_display.mode : old_step.input_base;
+      auto tokens = parse::parse(parse::ParserSettings(base, state.functions), history[i]);
+      size_t size_before = context.stack().data.size();
+      size_t old_size_before = old_stack.data.size();
+      // likewise with the width
+      context.set_int_width((i == entry) ? int_width.ToBits() : old_step.int_width);
+      // moved in, so the stack is edited in place rather than copied
+      state.Execute(std::move(context), tokens, false);
+      auto step = LiveHistory::MakeStep(state, size_before, base);
+      context = std::move(state.speculative);
+
+      LiveHistory::Apply(old_step, old_stack);
+      divergence.rerun(
+         context.stack(),
+         size_before - step.reads,
+         old_stack,
+         old_size_before - old_step.reads,
+         size_before,
+         old_size_before
+      );
+      context_differs = !SameRegisterAndVariables(context, old_step);
+      live_history.set_step(i, std::move(step));
+   }
+
+   live_history.update_checkpoint(end, context.stack());
+
+   context.set_int_width(int_width.ToBits());
+   state.committed = context;
+   state.speculative = std::move(context);
+   ++state.committed_version;
+}
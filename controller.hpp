@@ -2,10 +2,18 @@
 
 #include "calc/bit_register.hpp"
 #include "calc/calc.hpp"
+#include "calc/execution_cache.hpp"
 #include "calc/function.hpp"
+#include "calc/lanes.hpp"
+#include "history/HistoryStore.hpp"
+#include "history/LiveHistory.hpp"
+#include "history/PreviewWorker.hpp"
+#include "input.hpp"
 #include "raylib.h"
 #include "view/style.hpp"
+#include "watch/WatchWorker.hpp"
 #include <optional>
+#include <string_view>
 #include <vector>
 
 class EnumeratedMode {
@@ -179,6 +187,54 @@ struct IntWidthMode : public EnumeratedMode {
    }
 };
 
+/// @brief Shows the top of the stack as SIMD lanes of a type instead of as
+/// bits, see LaneDisplay
+struct LaneViewMode : public EnumeratedMode {
+   enum class Mode { kOff, kU8, kI8, kU16, kI16, kU32, kI32, kU64, kI64, kF32, kF64 };
+   Mode mode = Mode::kOff;
+   char const* DisplayString() const override {
+      switch(mode) {
+      case Mode::kOff:
+         return "bits";
+      case Mode::kU8:
+         return "u8";
+      case Mode::kI8:
+         return "i8";
+      case Mode::kU16:
+         return "u16";
+      case Mode::kI16:
+         return "i16";
+      case Mode::kU32:
+         return "u32";
+      case Mode::kI32:
+         return "i32";
+      case Mode::kU64:
+         return "u64";
+      case Mode::kI64:
+         return "i64";
+      case Mode::kF32:
+         return "f32";
+      case Mode::kF64:
+         return "f64";
+      }
+      return "";
+   }
+   char const* KeybindString() const override {
+      return "v";
+   }
+   void Rotate() override {
+      EnumRotate(mode, Mode::kF64);
+   }
+   /// @brief Nothing when the bits are shown
+   std::optional<lanes::Lane> ToLane() const {
+      if(mode == Mode::kOff) {
+         return std::nullopt;
+      }
+      // the modes after kOff are in lanes::Lane order
+      return static_cast<lanes::Lane>(static_cast<int>(mode) - 1);
+   }
+};
+
 struct FixMode : public EnumeratedMode {
    enum class Mode { kInfix, kPostfix };
    Mode mode = Mode::kPostfix;
@@ -228,6 +284,50 @@ struct FastEntryMode : public OnOffMode {
    }
 };
 
+/// @brief Records the effect of every committed entry so earlier entries
+/// can be edited, see LiveHistory
+struct LiveHistoryMode : public OnOffMode {
+   char const* KeybindString() const override {
+      return "g";
+   }
+
+   char const* DisplayString() const override {
+      switch(mode) {
+      case Mode::kOn:
+         return "live";
+         break;
+      case Mode::kOff:
+         return "static";
+         break;
+      }
+      return "";
+   }
+};
+
+/// @brief Change counters for the parts of the controller state that the view
+/// displays. A counter is bumped whenever that part may have changed, so the
+/// view can tell when a cached panel is stale without diffing the state.
+struct Revisions {
+   uint64_t input = 0;
+   uint64_t stack = 0;
+   uint64_t history = 0;
+   uint64_t modes = 0;
+   uint64_t reg = 0;
+   uint64_t search = 0;
+   uint64_t watches = 0;
+};
+
+/// @brief Ctrl+R incremental history search. While active, typed characters
+/// edit the query and the newest matching entry is shown in the input.
+struct HistorySearch {
+   bool active = false;
+   std::string query;
+   /// @brief False if nothing older than the last match contains the query
+   bool found = false;
+   /// @brief Input to restore if the search is cancelled
+   std::string saved_input;
+};
+
 // temp for test
 
 class Controller {
@@ -237,34 +337,111 @@ public:
    size_t highlighted_index = 0;
 
    calc::State state;
-   std::vector<std::string> history;
+   HistoryStore history;
 
    size_t history_highlighted_index = 0;
+   HistorySearch history_search;
+   PreviewWorker history_previews;
+
+   /// @brief Watch expressions in the order they were added
+   std::vector<Watch> watches;
+   WatchWorker watch_worker;
 
    EditorMode editor_mode;
    NumericDisplayMode input_display{"z"};
    NumericDisplayMode output_display{"x"};
    SeparatorMode sep_mode;
    IntWidthMode int_width;
+   LaneViewMode lane_view;
    FixMode fix_mode;
    FastEntryMode fast_entry_mode;
+   LiveHistoryMode live_history_mode;
+
+   LiveHistory live_history;
+   /// @brief History entry being edited in live history mode. Committing
+   /// replaces it and replays the entries after it.
+   std::optional<size_t> editing_entry;
 
-   RegisterDisplay theOnlyRegisterForNow = RegisterDisplay(std::vector<Field>());
-   RegisterDisplay& current_register = theOnlyRegisterForNow;
+   Revisions revisions;
 
+   bool show_profiler_overlay = false;
+
+   void OnInputEvent(InputEvent const& event);
    void OnCharPressed(int chr);
-   void OnKeyPressed(KeyboardKey k);
+   void OnKeyPressed(KeyboardKey k, KeyModifiers modifiers);
+   /// @brief Insert text at the cursor as a single edit
+   void InsertText(std::string_view text);
+   /// @brief Edits only mark the input for reparsing, this does the parse and
+   /// speculative execution once for all edits made since the last call. Call
+   /// once per frame after all input events have been handled.
+   void FlushPendingExecution();
+   /// @brief Ask the preview worker for the history rows [first, last). Cheap
+   /// when nothing changed, so it can be called every frame.
+   void RequestHistoryPreviews(size_t first, size_t last);
+   /// @brief Hand the speculative state to the watch worker if it changed.
+   /// Cheap when nothing changed, so it can be called every frame.
+   void UpdateWatches();
+   /// @brief Call after the committed state or modes were
+   /// replaced wholesale, e.g. when a saved session is loaded
+   void OnSessionRestored();
 
    std::string GetStackDisplayString(int index);
    std::string GetStackDisplayStringRadix(int index, NumericDisplayMode::Mode base);
+   /// @brief Byte buffers longer than this are displayed cut short
+   static constexpr size_t kMaxDisplayedBytes = 32;
+   /// @brief Bitsets with more runs of set bits are displayed cut short
+   static constexpr size_t kMaxDisplayedRuns = 16;
+   /// @brief Formats a value the way stack entries are displayed
+   std::string FormatValue(calc::Value const& item, NumericDisplayMode::Mode base);
 
    Controller();
 
 private:
+   bool m_execution_pending = false;
+   bool m_pending_reset_history_highlight = false;
+   /// @brief Makes revisiting an input, e.g. scrolling through history or
+   /// undoing an edit, a lookup instead of a reparse and execute
+   calc::ExecutionCache m_execution_cache;
+
+   struct PreviewRequestKey {
+      uint64_t committed_version = ~0ull;
+      NumericDisplayMode::Mode base = NumericDisplayMode::Mode::kDec;
+      size_t first = 0;
+      size_t last = 0;
+      size_t history_size = 0;
+
+      bool operator==(PreviewRequestKey const&) const = default;
+   };
+   PreviewRequestKey m_preview_request;
+   uint64_t m_next_watch_id = 0;
+   /// @brief revisions.stack when the watch worker last got the stack
+   uint64_t m_watched_stack_revision = ~0ull;
+   /// @brief Committed state before editing_entry, what the edit runs against
+   calc::Context m_edit_base;
+
+   void RequestExecution(bool reset_history_highlight);
    void ParseInput();
    void SpeculativelyExecuteInput(bool reset_history_highlight, bool allow_fast_entry);
    void OnCommit();
    void OnHistoryHighlightChanged();
+   /// @brief Handles a key while the history search is active, returns false
+   /// if the search does not use the key
+   bool OnHistorySearchKey(KeyboardKey k, KeyModifiers modifiers);
+   /// @brief Shows the newest match older than `before`
+   void UpdateHistorySearch(size_t before);
+   void EndHistorySearch(bool accept);
+   /// @brief Adds the input as a watch. A leading string names it, otherwise
+   /// the expression is its name.
+   void AddWatch(std::string_view input);
+   void RemoveNewestWatch();
+   /// @brief Makes the int_width mode the width words execute at
+   void ApplyIntWidth();
+   void SetLiveHistory(bool on);
+   void CommitHistoryEdit();
+   /// @brief Re-executes history from entry on, starting from the state
+   /// before it. Entries that do not read anything the edit changed are
+   /// skipped, and the replay stops once the state matches the recorded one.
+   void ReplayHistoryFrom(size_t entry);
    void DeleteOneChar();
    void CheckFastEntryCommit();
 };
\ No newline at end of file
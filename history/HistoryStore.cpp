@@ -0,0 +1,229 @@
+#include "history/HistoryStore.hpp"
+
+#include "perf/profiler.hpp"
+#include "persist/mapped_file.hpp"
+
+#include <algorithm>
+#include <charconv>
+
+static uint64_t Signature(std::string_view str) {
+   uint64_t signature = 0;
+   for(char c : str) {
+      signature |= 1ull << (static_cast<unsigned char>(c) & 63);
+   }
+   return signature;
+}
+
+static uint32_t Trigram(char a, char b, char c) {
+   return (static_cast<uint32_t>(static_cast<unsigned char>(a)) << 16) |
+          (static_cast<uint32_t>(static_cast<unsigned char>(b)) << 8) |
+          static_cast<uint32_t>(static_cast<unsigned char>(c));
+}
+
+static uint32_t Trigram(std::string_view str, size_t pos) {
+   return Trigram(str[pos], str[pos + 1], str[pos + 2]);
+}
+
+bool HistoryStore::open_log(std::string const& path) {
+   bool needs_newline = false;
+   {
+      persist::MappedFile file(path);
+      if(file.is_open()) {
+         auto bytes = file.bytes();
+         std::string_view text(reinterpret_cast<char const*>(bytes.data()), bytes.size());
+         size_t start = 0;
+         for(size_t end = text.find('\n'); end != std::string_view::npos;
+             end = text.find('\n', start)) {
+            if(end > start) {
+               load_line(text.substr(start, end - start));
+            }
+            start = end + 1;
+         }
+         // a partial last line is left by a session that died mid-write, end
+         // it so the next entry starts on its own line
+         needs_newline = start < text.size();
+      }
+   }
+   m_log.open(path, std::ios::binary | std::ios::app);
+   if(needs_newline) {
+      m_log << '\n';
+   }
+   return static_cast<bool>(m_log);
+}
+
+void HistoryStore::push_back(std::string_view entry) {
+   add(entry);
+   if(m_log.is_open()) {
+      m_log << entry << '\n';
+      m_log.flush();
+   }
+}
+
+void HistoryStore::replace(size_t index, std::string_view entry) {
+   unindex(index);
+   m_entries[index] = m_arena.store(entry);
+   index_entry(index);
+   if(m_log.is_open()) {
+      m_log << kReplaceMarker << index << ' ' << entry << '\n';
+      m_log.flush();
+   }
+}
+
+void HistoryStore::load_line(std::string_view line) {
+   if(line.front() != kReplaceMarker) {
+      add(line);
+      return;
+   }
+   size_t index = 0;
+   auto result = std::from_chars(line.data() + 1, line.data() + line.size(), index);
+   bool valid = (result.ec == std::errc()) && (result.ptr < line.data() + line.size()) &&
+                (*result.ptr == ' ') && (index < m_entries.size());
+   if(valid) {
+      auto entry = line.substr(result.ptr + 1 - line.data());
+      unindex(index);
+      m_entries[index] = m_arena.store(entry);
+      index_entry(index);
+   }
+}
+
+void HistoryStore::add(std::string_view entry) {
+   m_entries.push_back(m_arena.store(entry));
+   m_signatures.push_back(0);
+   index_entry(m_entries.size() - 1);
+}
+
+/// @brief Inserts index into an ascending list unless it is already there
+static void InsertSorted(std::vector<uint32_t>& postings, uint32_t index) {
+   // appending is the common case, and an entry repeating a trigram is
+   // only listed once
+   if(postings.empty() || (postings.back() < index)) {
+      postings.push_back(index);
+      return;
+   }
+   if(postings.back() == index) {
+      return;
+   }
+   auto it = std::lower_bound(postings.begin(), postings.end(), index);
+   if((it == postings.end()) || (*it != index)) {
+      postings.insert(it, index);
+   }
+}
+
+static void EraseSorted(std::vector<uint32_t>& postings, uint32_t index) {
+   auto it = std::lower_bound(postings.begin(), postings.end(), index);
+   if((it != postings.end()) && (*it == index)) {
+      postings.erase(it);
+   }
+}
+
+void HistoryStore::index_entry(size_t index) {
+   auto entry = m_entries[index];
+   auto index32 = static_cast<uint32_t>(index);
+   m_signatures[index] = Signature(entry);
+   if(entry.size() < 3) {
+      InsertSorted(m_short_entries, index32);
+   }
+   for(size_t i = 0; i + 3 <= entry.size(); ++i) {
+      InsertSorted(m_trigrams[Trigram(entry, i)], index32);
+   }
+}
+
+void HistoryStore::unindex(size_t index) {
+   auto entry = m_entries[index];
+   auto index32 = static_cast<uint32_t>(index);
+   if(entry.size() < 3) {
+      EraseSorted(m_short_entries, index32);
+   }
+   for(size_t i = 0; i + 3 <= entry.size(); ++i) {
+      if(auto it = m_trigrams.find(Trigram(entry, i)); it != m_trigrams.end()) {
+         EraseSorted(it->second, index32);
+      }
+   }
+}
+
+bool HistoryStore::matches(size_t index, std::string_view query, uint64_t signature) const {
+   return ((m_signatures[index] & signature) == signature) &&
+          (m_entries[index].find(query) != std::string_view::npos);
+}
+
+/// @brief Newest entry in an ascending posting list that is older than before
+static std::optional<size_t> NewestBefore(std::vector<uint32_t> const& postings, size_t before) {
+   auto it = std::lower_bound(postings.begin(), postings.end(), static_cast<uint32_t>(before));
+   if(it == postings.begin()) {
+      return std::nullopt;
+   }
+   return *(it - 1);
+}
+
+std::optional<size_t> HistoryStore::find_pair_before(std::string_view query, size_t before) const {
+   // every entry of three or more characters containing the pair has a
+   // trigram that starts or ends with it, so the newest match is the newest
+   // entry in any of those posting lists
+   std::optional<size_t> newest;
+   auto consider = [&](std::optional<size_t> candidate) {
+      if(candidate.has_value() && (!newest.has_value() || (*candidate > *newest))) {
+         newest = candidate;
+      }
+   };
+   for(int i = 0; i < 256; ++i) {
+      auto c = static_cast<char>(i);
+      for(uint32_t key : {Trigram(query[0], query[1], c), Trigram(c, query[0], query[1])}) {
+         if(auto it = m_trigrams.find(key); it != m_trigrams.end()) {
+            consider(NewestBefore(it->second, before));
+         }
+      }
+   }
+   for(auto index = NewestBefore(m_short_entries, before); index.has_value();
+       index = NewestBefore(m_short_entries, *index)) {
+      if(newest.has_value() && (*index < *newest)) {
+         break;
+      }
+      if(m_entries[*index] == query) {
+         consider(index);
+         break;
+      }
+   }
+   return newest;
+}
+
+std::optional<size_t> HistoryStore::find_before(std::string_view query, size_t before) const {
+   PROFILE_ZONE("HistoryStore::find_before");
+   before = std::min(before, m_entries.size());
+   if(query.empty()) {
+      return std::nullopt;
+   }
+   uint64_t signature = Signature(query);
+
+   if(query.size() == 2) {
+      return find_pair_before(query, before);
+   }
+   if(query.size() == 1) {
+      // the signatures reject most entries without touching their text
+      for(size_t i = before; i > 0; --i) {
+         if(matches(i - 1, query, signature)) {
+            return i - 1;
+         }
+      }
+      return std::nullopt;
+   }
+
+   std::vector<uint32_t> const* rarest = nullptr;
+   for(size_t i = 0; i + 3 <= query.size(); ++i) {
+      auto it = m_trigrams.find(Trigram(query, i));
+      if(it == m_trigrams.end()) {
+         return std::nullopt;
+      }
+      if((rarest == nullptr) || (it->second.size() < rarest->size())) {
+         rarest = &it->second;
+      }
+   }
+
+   auto end = std::lower_bound(rarest->begin(), rarest->end(), static_cast<uint32_t>(before));
+   for(auto it = end; it != rarest->begin();) {
+      --it;
+      if(matches(*it, query, signature)) {
+         return *it;
+      }
+   }
+   return std::nullopt;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "history/StringArena.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/// @brief Committed input history, oldest entry first.
+///
+/// Entries are kept in a StringArena and indexed for substring search: every
+/// entry gets a 64 bit signature of the characters it contains, and each
+/// distinct trigram maps to the ascending list of entries containing it. A
+/// search walks the shortest posting list of the query's trigrams backwards
+/// from the starting point, so finding the next match costs roughly the
+/// number of entries sharing the query's rarest trigram, not the size of the
+/// history.
+///
+/// When a log is opened, entries are loaded from it and every new entry is
+/// appended to it, one entry per line. Several sessions can share the same
+/// log. Replacing an entry appends a record naming the entry's index, so the
+/// log stays append-only.
+class HistoryStore {
+public:
+   /// @brief Starts a log line that replaces an earlier entry: the marker, then
+   /// "<index> <text>". A control character, so a plain entry can start with
+   /// any printable character including '~'. The controller checks that input
+   /// can never contain it.
+   static constexpr char kReplaceMarker = '\x1e';
+
+   /// @brief Load all entries from the log at path and append new entries to
+   /// it. Returns false if the log could not be opened for writing.
+   bool open_log(std::string const& path);
+
+   void push_back(std::string_view entry);
+
+   /// @brief Replace the text of an existing entry
+   void replace(size_t index, std::string_view entry);
+
+   size_t size() const {
+      return m_entries.size();
+   }
+
+   bool empty() const {
+      return m_entries.empty();
+   }
+
+   std::string_view operator[](size_t index) const {
+      return m_entries[index];
+   }
+
+   std::string_view back() const {
+      return m_entries.back();
+   }
+
+   /// @brief Index of the newest entry older than `before` that contains
+   /// query, or nullopt. An empty query matches nothing.
+   std::optional<size_t> find_before(std::string_view query, size_t before) const;
+
+private:
+   StringArena m_arena;
+   std::vector<std::string_view> m_entries;
+   std::vector<uint64_t> m_signatures;
+   std::unordered_map<uint32_t, std::vector<uint32_t>> m_trigrams;
+   /// @brief Entries too short to have a trigram
+   std::vector<uint32_t> m_short_entries;
+   std::ofstream m_log;
+
+   void add(std::string_view entry);
+   void load_line(std::string_view line);
+   void index_entry(size_t index);
+   void unindex(size_t index);
+   bool matches(size_t index, std::string_view query, uint64_t signature) const;
+   std::optional<size_t> find_pair_before(std::string_view query, size_t before) const;
+};
@@ -0,0 +1,80 @@
+#include "history/LiveHistory.hpp"
+
+#include <algorithm>
+
+LiveHistory::Step
+LiveHistory::MakeStep(calc::State const& state, size_t size_before, intbase::IntBase base) {
+   auto const& stack = state.speculative.stack().data;
+   size_t low_water = std::min(state.speculative_low_water, stack.size());
+   return Step{
+      .reads = size_before - low_water,
+      // a failed entry stopped before the word that failed, which depended
+      // on values the commit did not read
+      .reads_all = (state.speculative_low_water == 0) || state.speculate_poisoned,
+      .pushed = std::vector<calc::Value>(stack.begin() + low_water, stack.end()),
+      .reg = state.speculative.shared_reg(),
+      .variables = state.speculative.shared_variables(),
+      .input_base = base,
+      .int_width = state.speculative.int_width(),
+   };
+}
+
+void LiveHistory::Apply(Step const& step, calc::Stack& stack) {
+   stack.data.erase(stack.data.end() - step.reads, stack.data.end());
+   stack.data.insert(stack.data.end(), step.pushed.begin(), step.pushed.end());
+}
+
+void LiveHistory::start(size_t first_entry, calc::Context context) {
+   m_active = true;
+   m_first = first_entry;
+   m_base = std::move(context);
+   m_steps.clear();
+   m_checkpoints.clear();
+}
+
+void LiveHistory::stop() {
+   m_active = false;
+   m_base = calc::Context{};
+   m_steps.clear();
+   m_checkpoints.clear();
+}
+
+void LiveHistory::record(Step step) {
+   m_steps.push_back(std::move(step));
+   if((m_steps.size() % kCheckpointInterval) != 0) {
+      return;
+   }
+   // built from the previous checkpoint, so each costs one interval of steps
+   calc::Stack stack = m_checkpoints.empty() ? m_base.stack() : m_checkpoints.back();
+   for(size_t i = m_steps.size() - kCheckpointInterval; i < m_steps.size(); ++i) {
+      Apply(m_steps[i], stack);
+   }
+   m_checkpoints.push_back(std::move(stack));
+}
+
+void LiveHistory::update_checkpoint(size_t entry, calc::Stack const& stack) {
+   size_t offset = entry - m_first;
+   if((offset == 0) || ((offset % kCheckpointInterval) != 0)) {
+      return;
+   }
+   size_t index = offset / kCheckpointInterval - 1;
+   if(index < m_checkpoints.size()) {
+      m_checkpoints[index] = stack;
+   }
+}
+
+calc::Context LiveHistory::before(size_t entry) const {
+   calc::Context context = m_base;
+   if(entry == m_first) {
+      return context;
+   }
+   size_t checkpoints = std::min((entry - m_first) / kCheckpointInterval, m_checkpoints.size());
+   calc::Stack stack = (checkpoints == 0) ? m_base.stack() : m_checkpoints[checkpoints - 1];
+   for(size_t i = m_first + checkpoints * kCheckpointInterval; i < entry; ++i) {
+      Apply(step(i), stack);
+   }
+   context.set_stack(std::move(stack));
+   context.set_shared_reg(step(entry - 1).reg);
+   context.set_shared_variables(step(entry - 1).variables);
+   return context;
+}
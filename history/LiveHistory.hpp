@@ -0,0 +1,101 @@
+#pragma once
+
+#include "calc/calc.hpp"
+#include "calc/context.hpp"
+#include "calc/intbase.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/// @brief The effect of every committed history entry, so an earlier entry
+/// can be edited and only the entries after it replayed.
+///
+/// Each entry is kept as a step: the values it read are popped from the top of
+/// the stack and its outputs are pushed. The stack before every
+/// kCheckpointInterval-th entry is kept as a checkpoint, and any state in the
+/// chain is rebuilt by applying steps to the checkpoint before it. An entry
+/// that only read values an edit did not change has the same step afterwards,
+/// so a replay can apply it without executing it.
+///
+/// Tracking starts at some history index with the state before it, usually
+/// when live history is switched on, and covers every entry committed after
+/// that. Entries before the start cannot be edited.
+class LiveHistory {
+public:
+   struct Step {
+      /// @brief Number of values the entry popped from the top of the stack
+      size_t reads = 0;
+      /// @brief The entry depended on the whole stack, see
+      /// calc::State::speculative_low_water
+      bool reads_all = false;
+      /// @brief Values the entry left on top
+      std::vector<calc::Value> pushed;
+      /// @brief Register layout and variables afterwards, shared with the
+      /// context the entry committed
+      std::shared_ptr<RegisterDisplay const> reg;
+      std::shared_ptr<calc::Variables const> variables;
+      /// @brief Base the entry was parsed with, so a replay reads its numbers
+      /// the same way even if the input mode changed since
+      intbase::IntBase input_base = intbase::IntBase::kDec;
+      /// @brief Int width the entry ran at, see calc::Context::int_width
+      int int_width = 64;
+   };
+
+   /// @brief The step of an entry that was just executed and committed on a
+   /// stack of size_before values
+   static Step MakeStep(calc::State const& state, size_t size_before, intbase::IntBase base);
+
+   static void Apply(Step const& step, calc::Stack& stack);
+
+   bool active() const {
+      return m_active;
+   }
+
+   /// @brief Start tracking entries from first_entry on, the context is the
+   /// state before it
+   void start(size_t first_entry, calc::Context context);
+   void stop();
+
+   /// @brief Entries between checkpoints, so rebuilding a state applies fewer
+   /// steps than this
+   static constexpr size_t kCheckpointInterval = 64;
+
+   /// @brief Append the step of the next entry
+   void record(Step step);
+
+   /// @brief True if the entry's step is known
+   bool contains(size_t entry) const {
+      return m_active && (entry >= m_first) && (entry < end());
+   }
+
+   size_t end() const {
+      return m_first + m_steps.size();
+   }
+
+   Step const& step(size_t entry) const {
+      return m_steps[entry - m_first];
+   }
+
+   /// @brief Replace the step of an entry. The checkpoints after it are left
+   /// alone, see update_checkpoint.
+   void set_step(size_t entry, Step step) {
+      m_steps[entry - m_first] = std::move(step);
+   }
+
+   /// @brief A replay passes the stack before each entry it reaches here,
+   /// which replaces the checkpoint if there is one before that entry
+   void update_checkpoint(size_t entry, calc::Stack const& stack);
+
+   /// @brief Rebuilds the context before an entry from the base
+   calc::Context before(size_t entry) const;
+
+private:
+   bool m_active = false;
+   size_t m_first = 0;
+   calc::Context m_base;
+   std::vector<Step> m_steps;
+   /// @brief Element i is the stack before entry m_first + (i + 1) *
+   /// kCheckpointInterval
+   std::vector<calc::Stack> m_checkpoints;
+};
@@ -0,0 +1,143 @@
+#include "history/PreviewWorker.hpp"
+
+#include "calc/parse.hpp"
+#include "perf/profiler.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+
+static constexpr size_t kMaxResults = 1024;
+
+PreviewWorker::PreviewWorker() : m_thread(&PreviewWorker::run, this) {}
+
+PreviewWorker::~PreviewWorker() {
+   {
+      std::lock_guard lock(m_mutex);
+      m_stop = true;
+   }
+   m_wake.notify_one();
+   m_thread.join();
+}
+
+void PreviewWorker::set_checkpoint(uint64_t key, calc::Context context, intbase::IntBase base) {
+   std::lock_guard lock(m_mutex);
+   if((key == m_checkpoint.key) && (base == m_checkpoint.base)) {
+      return;
+   }
+   for(auto& [index, result] : m_results) {
+      if((base != m_checkpoint.base) || !still_valid(result, m_checkpoint.context, context)) {
+         result.preview.stale = true;
+      }
+   }
+   m_checkpoint = Checkpoint{key, std::move(context), base};
+   m_revision.fetch_add(1, std::memory_order_release);
+}
+
+void PreviewWorker::request(std::vector<Request> rows) {
+   {
+      std::lock_guard lock(m_mutex);
+      if(m_results.size() > kMaxResults) {
+         std::unordered_set<size_t> wanted;
+         for(auto const& row : rows) {
+            wanted.insert(row.index);
+         }
+         std::erase_if(m_results, [&](auto const& entry) { return !wanted.contains(entry.first); });
+      }
+      m_pending.clear();
+      for(auto& row : rows) {
+         auto it = m_results.find(row.index);
+         bool up_to_date = (it != m_results.end()) && !it->second.preview.stale &&
+                           (it->second.input == row.input);
+         if(!up_to_date) {
+            m_pending.push_back(std::move(row));
+         }
+      }
+      if(m_pending.empty()) {
+         return;
+      }
+   }
+   m_wake.notify_one();
+}
+
+std::optional<HistoryPreview> PreviewWorker::get(size_t index, std::string_view input) const {
+   std::lock_guard lock(m_mutex);
+   auto it = m_results.find(index);
+   if((it == m_results.end()) || (it->second.input != input)) {
+      return std::nullopt;
+   }
+   return it->second.preview;
+}
+
+bool PreviewWorker::still_valid(
+   Result const& result, calc::Context const& old, calc::Context const& now
+) {
+   if(old.int_width() != now.int_width()) {
+      return false;
+   }
+   if(result.reads_variables && (old.shared_variables() != now.shared_variables()) &&
+      (old.variables() != now.variables())) {
+      return false;
+   }
+   auto const& old_data = old.stack().data;
+   auto const& now_data = now.stack().data;
+   if(result.reads_all) {
+      return old_data == now_data;
+   }
+   if(now_data.size() < result.reads) {
+      return false;
+   }
+   return std::equal(old_data.end() - result.reads, old_data.end(), now_data.end() - result.reads);
+}
+
+PreviewWorker::Result PreviewWorker::compute(std::string const& input, intbase::IntBase base) {
+   PROFILE_ZONE("PreviewWorker::compute");
+   auto tokens = parse::parse(parse::ParserSettings(base, m_state.functions), input);
+   m_state.Execute(tokens, true);
+
+   auto const& stack = m_state.speculative.stack().data;
+   size_t start_size = m_state.committed.stack().data.size();
+   // the top value is produced by the entry unless it ended below its start
+   size_t depends_from = m_state.speculative_low_water;
+   if(!stack.empty()) {
+      depends_from = std::min(depends_from, stack.size() - 1);
+   }
+
+   Result result{
+      .input = input,
+      .preview = HistoryPreview{},
+      .reads = start_size - depends_from,
+      .reads_all = m_state.speculative_low_water == 0,
+      .reads_variables = m_state.speculative_read_variables,
+   };
+   if(!m_state.speculate_poisoned && !stack.empty()) {
+      result.preview.top = stack.back();
+   }
+   return result;
+}
+
+void PreviewWorker::run() {
+   std::unique_lock lock(m_mutex);
+   while(true) {
+      m_wake.wait(lock, [this] { return m_stop || !m_pending.empty(); });
+      if(m_stop) {
+         return;
+      }
+      auto request = std::move(m_pending.front());
+      m_pending.pop_front();
+      auto checkpoint = m_checkpoint;
+      lock.unlock();
+
+      if(checkpoint.key != m_state_key) {
+         m_state.committed = std::move(checkpoint.context);
+         m_state_key = checkpoint.key;
+      }
+      auto result = compute(request.input, checkpoint.base);
+
+      lock.lock();
+      // drop the result if the checkpoint moved on while it was computed
+      if((m_checkpoint.key == checkpoint.key) && (m_checkpoint.base == checkpoint.base)) {
+         m_results.insert_or_assign(request.index, std::move(result));
+         m_revision.fetch_add(1, std::memory_order_release);
+      }
+   }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "calc/calc.hpp"
+#include "calc/intbase.hpp"
+#include "calc/value.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/// @brief What a history entry would produce if it was run against the
+/// current committed state
+struct HistoryPreview {
+   /// @brief Top of the stack afterwards, empty if execution failed, would
+   /// have needed a commit, or left the stack empty
+   std::optional<calc::Value> top;
+   /// @brief Computed against an older committed state and not yet redone
+   bool stale = false;
+};
+
+/// @brief Computes history previews on a background thread.
+///
+/// The UI hands over a checkpoint of the committed state whenever it changes,
+/// and the list of rows it is showing. The worker runs each requested entry
+/// against its own copy of the checkpoint with its own calc::State, and
+/// publishes results one at a time. The lock is only held to swap requests
+/// and results, never while an entry is executing, so the UI never waits for
+/// a preview.
+///
+/// When the checkpoint changes, a preview stays valid if the values it read
+/// from the top of the stack, and the variables if it loaded any, are
+/// unchanged, so only entries that depend on what changed are rerun. The
+/// others are kept as stale until redone.
+class PreviewWorker {
+public:
+   struct Request {
+      size_t index;
+      std::string input;
+   };
+
+   PreviewWorker();
+   ~PreviewWorker();
+   PreviewWorker(PreviewWorker const&) = delete;
+   PreviewWorker& operator=(PreviewWorker const&) = delete;
+
+   /// @brief Replace the state and parse settings that previews run against
+   void set_checkpoint(uint64_t key, calc::Context context, intbase::IntBase base);
+
+   /// @brief Replace the outstanding requests. Rows with an up to date
+   /// preview for the same input are skipped.
+   void request(std::vector<Request> rows);
+
+   /// @brief The preview for a row if one has been computed for this input
+   std::optional<HistoryPreview> get(size_t index, std::string_view input) const;
+
+   /// @brief Bumped whenever a preview is published or becomes stale
+   uint64_t revision() const {
+      return m_revision.load(std::memory_order_acquire);
+   }
+
+private:
+   struct Checkpoint {
+      uint64_t key = ~0ull;
+      /// @brief Shares its parts, so the worker takes it without copying them
+      /// under the lock
+      calc::Context context;
+      intbase::IntBase base = intbase::IntBase::kDec;
+   };
+
+   struct Result {
+      std::string input;
+      HistoryPreview preview;
+      /// @brief Number of values from the top of the checkpoint the result
+      /// depends on
+      size_t reads;
+      /// @brief The result also depends on the checkpoint size
+      bool reads_all;
+      bool reads_variables;
+   };
+
+   mutable std::mutex m_mutex;
+   std::condition_variable m_wake;
+   bool m_stop = false;
+   Checkpoint m_checkpoint;
+   std::deque<Request> m_pending;
+   std::unordered_map<size_t, Result> m_results;
+   std::atomic<uint64_t> m_revision{0};
+
+   // only touched by the worker thread
+   calc::State m_state;
+   uint64_t m_state_key = ~0ull;
+
+   std::thread m_thread;
+
+   void run();
+   Result compute(std::string const& input, intbase::IntBase base);
+   static bool
+   still_valid(Result const& result, calc::Context const& old, calc::Context const& now);
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/// @brief Append-only storage for many small strings. Strings are packed into
+/// large blocks and never move, so the returned views stay valid for the
+/// lifetime of the arena.
+class StringArena {
+public:
+   std::string_view store(std::string_view str) {
+      if(str.size() > kBlockSize / 4) {
+         // big strings get their own block so they don't waste the tail of
+         // the current one
+         m_blocks.push_back(std::make_unique<char[]>(str.size()));
+         std::memcpy(m_blocks.back().get(), str.data(), str.size());
+         return {m_blocks.back().get(), str.size()};
+      }
+      if(m_current == nullptr || (m_used + str.size() > kBlockSize)) {
+         m_blocks.push_back(std::make_unique<char[]>(kBlockSize));
+         m_current = m_blocks.back().get();
+         m_used = 0;
+      }
+      char* dest = m_current + m_used;
+      std::memcpy(dest, str.data(), str.size());
+      m_used += str.size();
+      return {dest, str.size()};
+   }
+
+   void clear() {
+      m_blocks.clear();
+      m_current = nullptr;
+      m_used = 0;
+   }
+
+private:
+   static constexpr size_t kBlockSize = 1 << 16;
+
+   std::vector<std::unique_ptr<char[]>> m_blocks;
+   char* m_current = nullptr;
+   size_t m_used = 0;
+};
@@ -0,0 +1,74 @@
+#include "input.hpp"
+
+static KeyModifiers CurrentModifiers() {
+   return KeyModifiers{
+      .control = IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL),
+      .shift = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT),
+   };
+}
+
+std::vector<InputEvent> DrainInputEvents(uint64_t frame) {
+   std::vector<InputEvent> events;
+   for(int chr = GetCharPressed(); chr != 0; chr = GetCharPressed()) {
+      events.push_back(InputEvent::make_char(frame, chr));
+   }
+   auto modifiers = CurrentModifiers();
+   for(int key = GetKeyPressed(); key != 0; key = GetKeyPressed()) {
+      if((key == KEY_V) && modifiers.control) {
+         char const* clipboard = GetClipboardText();
+         if(clipboard != nullptr) {
+            events.push_back(InputEvent::make_paste(frame, clipboard));
+         }
+         continue;
+      }
+      events.push_back(InputEvent::make_key(frame, static_cast<KeyboardKey>(key), modifiers));
+   }
+   return events;
+}
+
+static char TypeChar(InputEvent::Type type) {
+   switch(type) {
+   case InputEvent::Type::kChar:
+      return 'c';
+   case InputEvent::Type::kKey:
+      return 'k';
+   case InputEvent::Type::kPaste:
+      return 'p';
+   }
+   return '?';
+}
+
+void WriteInputEvent(std::ostream& out, InputEvent const& event) {
+   out << event.frame << ' ' << TypeChar(event.type) << ' ' << event.code << ' '
+       << event.modifiers.control << ' ' << event.modifiers.shift << ' ' << event.text.size()
+       << ':' << event.text << '\n';
+}
+
+std::optional<InputEvent> ReadInputEvent(std::istream& in) {
+   uint64_t frame;
+   char type;
+   int code;
+   bool control;
+   bool shift;
+   size_t text_size;
+   char colon;
+   if(!(in >> frame >> type >> code >> control >> shift >> text_size >> colon) || (colon != ':')) {
+      return std::nullopt;
+   }
+   std::string text(text_size, '\0');
+   if(!in.read(text.data(), text_size)) {
+      return std::nullopt;
+   }
+
+   auto modifiers = KeyModifiers{.control = control, .shift = shift};
+   switch(type) {
+   case 'c':
+      return InputEvent::make_char(frame, code);
+   case 'k':
+      return InputEvent::make_key(frame, static_cast<KeyboardKey>(code), modifiers);
+   case 'p':
+      return InputEvent::make_paste(frame, std::move(text));
+   default:
+      return std::nullopt;
+   }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "raylib.h"
+
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct KeyModifiers {
+   bool control = false;
+   bool shift = false;
+};
+
+/// @brief One user input, decoupled from raylib's global input state so that a
+/// session can be recorded and replayed deterministically.
+struct InputEvent {
+   enum class Type { kChar, kKey, kPaste };
+
+   static InputEvent make_char(uint64_t frame, int chr) {
+      return InputEvent{frame, Type::kChar, chr, KeyModifiers{}, ""};
+   }
+   static InputEvent make_key(uint64_t frame, KeyboardKey key, KeyModifiers modifiers) {
+      return InputEvent{frame, Type::kKey, static_cast<int>(key), modifiers, ""};
+   }
+   static InputEvent make_paste(uint64_t frame, std::string text) {
+      return InputEvent{frame, Type::kPaste, 0, KeyModifiers{}, std::move(text)};
+   }
+
+   /// @brief Frame the event was received on. Events of one frame are handled
+   /// together before that frame is rendered.
+   uint64_t frame;
+   Type type;
+   /// @brief Unicode codepoint for kChar, KeyboardKey for kKey
+   int code;
+   KeyModifiers modifiers;
+   /// @brief used for kPaste
+   std::string text;
+};
+
+/// @brief Drains raylib's char and key queues. Ctrl+V is turned into a kPaste
+/// event carrying the clipboard contents.
+std::vector<InputEvent> DrainInputEvents(uint64_t frame);
+
+/// @brief Events are stored one per line as
+/// `<frame> <c|k|p> <code> <ctrl> <shift> <text length>:<text>`
+void WriteInputEvent(std::ostream& out, InputEvent const& event);
+std::optional<InputEvent> ReadInputEvent(std::istream& in);
@@ -1,16 +1,80 @@
 #include "raylib.h"
 
-#include "view/view.hpp"
 #include "controller.hpp"
+#include "input.hpp"
+#include "persist/session.hpp"
+#include "perf/profiler.hpp"
+#include "perf/replay.hpp"
+#include "view/MonoFont.hpp"
+#include "view/view.hpp"
 
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <optional>
 #include <string_view>
 using namespace std::literals;
 
-int main(void) {
+static void PrintUsage() {
+   std::cerr << "usage: main [--record <file>] [--no-session]\n"
+                "       main --replay <file> [--headless] [--alloc-budget <allocs per frame>]"
+                " [--warmup <frames>]\n"
+                "--record implies --no-session, since a replay starts without one\n";
+}
+
+int main(int argc, char** argv) {
+   std::optional<std::string> record_path;
+   bool replay = false;
+   bool use_session = true;
+   ReplayOptions replay_options;
+   for(int i = 1; i < argc; ++i) {
+      auto arg = std::string_view(argv[i]);
+      if((arg == "--record"sv) && (i + 1 < argc)) {
+         record_path = argv[++i];
+      } else if((arg == "--replay"sv) && (i + 1 < argc)) {
+         replay = true;
+         replay_options.path = argv[++i];
+      } else if(arg == "--no-session"sv) {
+         use_session = false;
+      } else if(arg == "--headless"sv) {
+         replay_options.headless = true;
+      } else if((arg == "--alloc-budget"sv) && (i + 1 < argc)) {
+         replay_options.alloc_budget = std::strtoull(argv[++i], nullptr, 10);
+      } else if((arg == "--warmup"sv) && (i + 1 < argc)) {
+         replay_options.warmup_frames = std::strtoull(argv[++i], nullptr, 10);
+      } else {
+         PrintUsage();
+         return 1;
+      }
+   }
+   if(replay) {
+      return RunReplay(replay_options);
+   }
+   // a replay starts from an empty controller, so the recording has to as
+   // well for the replayed events to do the same thing
+   if(record_path.has_value()) {
+      use_session = false;
+   }
+
+   std::ofstream recording;
+   if(record_path.has_value()) {
+      recording.open(*record_path, std::ios::binary);
+      if(!recording) {
+         std::cerr << "cannot open " << *record_path << " for recording\n";
+         return 1;
+      }
+   }
+
    Controller viewmodel;
    View view(viewmodel);
 
+   session::Autosaver autosaver(session::DefaultPath());
+   if(use_session) {
+      viewmodel.history.open_log(session::HistoryLogPath());
+      session::Load(viewmodel, session::DefaultPath());
+      autosaver.MarkSaved(viewmodel);
+   }
+
    const int screenWidth = 850;
    const int screenHeight = 450;
    SetConfigFlags(FLAG_WINDOW_RESIZABLE);
@@ -22,17 +86,36 @@ int main(void) {
    SetWindowMinSize(screenWidth, screenHeight);
    SetTargetFPS(60);
    SetExitKey(0);
+   MonoFont::get().load();
+   uint64_t frame = 0;
    while(!WindowShouldClose()) {
-      viewmodel.OnCharPressed(GetCharPressed());
-
-      auto key = static_cast<KeyboardKey>(GetKeyPressed());
-      viewmodel.OnKeyPressed(key);
+      {
+         // excludes EndDrawing, which waits for the next frame
+         PROFILE_ZONE("frame");
+         {
+            PROFILE_ZONE("input");
+            // drain the whole queues so fast typing is handled in one frame,
+            // then reparse once for all of the edits
+            for(auto const& event : DrainInputEvents(frame)) {
+               if(recording.is_open()) {
+                  WriteInputEvent(recording, event);
+               }
+               viewmodel.OnInputEvent(event);
+            }
+            viewmodel.FlushPendingExecution();
+         }
+         if(use_session) {
+            autosaver.Update(viewmodel);
+         }
 
-      BeginDrawing();
-      ClearBackground(WHITE);
-      view.render();
+         BeginDrawing();
+         ClearBackground(WHITE);
+         view.render();
+      }
       EndDrawing();
+      ++frame;
    }
+   MonoFont::get().unload();
    CloseWindow();
    return 0;
-}
\ No newline at end of file
+}
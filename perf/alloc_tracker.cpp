@@ -0,0 +1,113 @@
+#include "perf/alloc_tracker.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace alloc_tracker {
+
+namespace {
+struct AtomicCounts {
+   std::atomic<uint64_t> allocations{0};
+   std::atomic<uint64_t> bytes{0};
+};
+
+// plain globals so they are usable before any static constructor runs
+std::array<AtomicCounts, static_cast<size_t>(Phase::kCount)> g_counts;
+thread_local Phase t_phase = Phase::kOther;
+} // namespace
+
+char const* PhaseName(Phase phase) {
+   switch(phase) {
+   case Phase::kOther:
+      return "other";
+   case Phase::kParse:
+      return "parse";
+   case Phase::kExecute:
+      return "execute";
+   case Phase::kFormat:
+      return "format";
+   case Phase::kRender:
+      return "render";
+   case Phase::kCount:
+      break;
+   }
+   return "";
+}
+
+PhaseCounts Snapshot::total() const {
+   PhaseCounts sum;
+   for(auto const& counts : phases) {
+      sum.allocations += counts.allocations;
+      sum.bytes += counts.bytes;
+   }
+   return sum;
+}
+
+Snapshot Snapshot::since(Snapshot const& earlier) const {
+   Snapshot diff;
+   for(size_t i = 0; i < phases.size(); ++i) {
+      diff.phases[i].allocations = phases[i].allocations - earlier.phases[i].allocations;
+      diff.phases[i].bytes = phases[i].bytes - earlier.phases[i].bytes;
+   }
+   return diff;
+}
+
+Snapshot TakeSnapshot() {
+   Snapshot snapshot;
+   for(size_t i = 0; i < g_counts.size(); ++i) {
+      snapshot.phases[i].allocations = g_counts[i].allocations.load(std::memory_order_relaxed);
+      snapshot.phases[i].bytes = g_counts[i].bytes.load(std::memory_order_relaxed);
+   }
+   return snapshot;
+}
+
+Phase CurrentPhase() {
+   return t_phase;
+}
+
+ScopedPhase::ScopedPhase(Phase phase) : m_previous(t_phase) {
+   t_phase = phase;
+}
+
+ScopedPhase::~ScopedPhase() {
+   t_phase = m_previous;
+}
+
+#if defined(CALC_TRACK_ALLOCATIONS) && CALC_TRACK_ALLOCATIONS
+static void* CountedAlloc(std::size_t size) {
+   auto& counts = g_counts[static_cast<size_t>(t_phase)];
+   counts.allocations.fetch_add(1, std::memory_order_relaxed);
+   counts.bytes.fetch_add(size, std::memory_order_relaxed);
+   if(void* ptr = std::malloc(size == 0 ? 1 : size)) {
+      return ptr;
+   }
+   throw std::bad_alloc();
+}
+#endif
+
+} // namespace alloc_tracker
+
+#if defined(CALC_TRACK_ALLOCATIONS) && CALC_TRACK_ALLOCATIONS
+// Replacing these four (plus the sized deletes) is enough: the standard
+// library's nothrow variants forward to them. Over-aligned allocations are
+// not counted.
+void* operator new(std::size_t size) {
+   return alloc_tracker::CountedAlloc(size);
+}
+void* operator new[](std::size_t size) {
+   return alloc_tracker::CountedAlloc(size);
+}
+void operator delete(void* ptr) noexcept {
+   std::free(ptr);
+}
+void operator delete[](void* ptr) noexcept {
+   std::free(ptr);
+}
+void operator delete(void* ptr, std::size_t) noexcept {
+   std::free(ptr);
+}
+void operator delete[](void* ptr, std::size_t) noexcept {
+   std::free(ptr);
+}
+#endif
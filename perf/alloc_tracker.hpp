@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/// Allocation accounting for the hot path.
+///
+/// When built with CALC_TRACK_ALLOCATIONS (cmake -DCALC_TRACK_ALLOCATIONS=ON)
+/// the global operator new is replaced by one that counts every allocation and
+/// its size, attributed to the phase the allocating thread is currently in.
+/// Otherwise phases are still tracked but every count stays zero.
+namespace alloc_tracker {
+
+#if defined(CALC_TRACK_ALLOCATIONS) && CALC_TRACK_ALLOCATIONS
+inline constexpr bool kEnabled = true;
+#else
+inline constexpr bool kEnabled = false;
+#endif
+
+enum class Phase { kOther, kParse, kExecute, kFormat, kRender, kCount };
+
+char const* PhaseName(Phase phase);
+
+struct PhaseCounts {
+   uint64_t allocations = 0;
+   uint64_t bytes = 0;
+};
+
+struct Snapshot {
+   std::array<PhaseCounts, static_cast<size_t>(Phase::kCount)> phases{};
+
+   PhaseCounts const& operator[](Phase phase) const {
+      return phases[static_cast<size_t>(phase)];
+   }
+
+   PhaseCounts total() const;
+
+   /// @brief Counts that happened between earlier and this snapshot
+   Snapshot since(Snapshot const& earlier) const;
+};
+
+Snapshot TakeSnapshot();
+
+Phase CurrentPhase();
+
+/// @brief Attributes allocations on this thread to phase for its lifetime.
+/// Phases nest, the innermost one wins.
+class ScopedPhase {
+public:
+   explicit ScopedPhase(Phase phase);
+   ~ScopedPhase();
+   ScopedPhase(ScopedPhase const&) = delete;
+   ScopedPhase& operator=(ScopedPhase const&) = delete;
+
+private:
+   Phase m_previous;
+};
+
+} // namespace alloc_tracker
+
+#define ALLOC_PHASE_CONCAT_INNER(a, b) a##b
+#define ALLOC_PHASE_CONCAT(a, b) ALLOC_PHASE_CONCAT_INNER(a, b)
+#define ALLOC_PHASE(phase) \
+   ::alloc_tracker::ScopedPhase ALLOC_PHASE_CONCAT(alloc_phase_, __LINE__)(phase)
@@ -0,0 +1,69 @@
+#include "perf/latency_histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+
+static double percentile_of_sorted(std::vector<double> const& sorted, double p) {
+   if(sorted.empty()) {
+      return 0.0;
+   }
+   auto rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+   rank = std::clamp<size_t>(rank, 1, sorted.size());
+   return sorted[rank - 1];
+}
+
+double LatencyHistogram::percentile(double p) const {
+   auto sorted = m_samples;
+   std::sort(sorted.begin(), sorted.end());
+   return percentile_of_sorted(sorted, p);
+}
+
+void LatencyHistogram::report(std::ostream& out) const {
+   static constexpr int kBarWidth = 40;
+
+   auto sorted = m_samples;
+   std::sort(sorted.begin(), sorted.end());
+   out << std::format(
+      "{}: n={} p50={:.1f}{} p90={:.1f}{} p99={:.1f}{} p99.9={:.1f}{} max={:.1f}{}\n",
+      m_name,
+      sorted.size(),
+      percentile_of_sorted(sorted, 50),
+      m_unit,
+      percentile_of_sorted(sorted, 90),
+      m_unit,
+      percentile_of_sorted(sorted, 99),
+      m_unit,
+      percentile_of_sorted(sorted, 99.9),
+      m_unit,
+      sorted.empty() ? 0.0 : sorted.back(),
+      m_unit
+   );
+   if(sorted.empty()) {
+      return;
+   }
+
+   // bucket i holds samples in [2^i, 2^(i+1)), bucket 0 also holds everything
+   // below 1
+   std::vector<size_t> buckets;
+   for(double sample : sorted) {
+      size_t bucket = sample < 1.0 ? 0 : static_cast<size_t>(std::log2(sample));
+      if(bucket >= buckets.size()) {
+         buckets.resize(bucket + 1, 0);
+      }
+      ++buckets[bucket];
+   }
+   size_t max_count = *std::max_element(buckets.begin(), buckets.end());
+   for(size_t i = 0; i < buckets.size(); ++i) {
+      int bar = static_cast<int>(buckets[i] * kBarWidth / max_count);
+      out << std::format(
+         "  [{:>8}, {:>8}) {} | {:<{}} {}\n",
+         i == 0 ? 0 : (size_t{1} << i),
+         size_t{1} << (i + 1),
+         m_unit,
+         std::string(bar, '#'),
+         kBarWidth,
+         buckets[i]
+      );
+   }
+}
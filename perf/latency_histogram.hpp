@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// @brief Collects latency samples and reports percentiles plus a log2 bucketed
+/// histogram. Samples are microseconds unless another unit is given, e.g. for
+/// allocation counts.
+class LatencyHistogram {
+public:
+   explicit LatencyHistogram(std::string name, std::string unit = "us") :
+      m_name(std::move(name)),
+      m_unit(std::move(unit)) {}
+
+   void add(double sample) {
+      m_samples.push_back(sample);
+   }
+
+   size_t count() const {
+      return m_samples.size();
+   }
+
+   /// @brief p in [0, 100]. Returns 0 if there are no samples.
+   double percentile(double p) const;
+
+   void report(std::ostream& out) const;
+
+private:
+   std::string m_name;
+   std::string m_unit;
+   std::vector<double> m_samples;
+};
@@ -0,0 +1,146 @@
+#include "perf/profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <map>
+
+namespace profiler {
+
+static int64_t SteadyNowNs() {
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()
+   )
+      .count();
+}
+
+static uint32_t CurrentThreadIndex() {
+   static std::atomic<uint32_t> next_index{1};
+   thread_local uint32_t index = next_index.fetch_add(1, std::memory_order_relaxed);
+   return index;
+}
+
+static double PercentileOfSorted(std::vector<double> const& sorted, double p) {
+   if(sorted.empty()) {
+      return 0.0;
+   }
+   auto rank = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size() - 1));
+   return sorted[rank];
+}
+
+Profiler::Profiler() : m_epoch_ns(SteadyNowNs()) {}
+
+Profiler& Profiler::get() {
+   // heap allocated, the slot array is too large for some static segments and
+   // it is intentionally never destroyed so zones in static destructors work
+   static Profiler* profiler = new Profiler();
+   return *profiler;
+}
+
+uint64_t Profiler::now_ns() const {
+   return static_cast<uint64_t>(SteadyNowNs() - m_epoch_ns);
+}
+
+void Profiler::record(char const* name, uint64_t start_ns, uint64_t end_ns) {
+   uint64_t index = m_write_index.fetch_add(1, std::memory_order_relaxed);
+   Slot& slot = m_slots[index % kCapacity];
+   slot.sequence.store(0, std::memory_order_relaxed);
+   std::atomic_thread_fence(std::memory_order_release);
+   slot.name.store(name, std::memory_order_relaxed);
+   slot.start_ns.store(start_ns, std::memory_order_relaxed);
+   slot.end_ns.store(end_ns, std::memory_order_relaxed);
+   slot.thread.store(CurrentThreadIndex(), std::memory_order_relaxed);
+   slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+std::optional<ZoneEvent> Profiler::read(uint64_t index) const {
+   Slot const& slot = m_slots[index % kCapacity];
+   uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+   if(sequence != index + 1) {
+      // still being written, or already overwritten by a newer event
+      return std::nullopt;
+   }
+   ZoneEvent event{
+      slot.name.load(std::memory_order_relaxed),
+      slot.start_ns.load(std::memory_order_relaxed),
+      slot.end_ns.load(std::memory_order_relaxed),
+      slot.thread.load(std::memory_order_relaxed),
+   };
+   std::atomic_thread_fence(std::memory_order_acquire);
+   if(slot.sequence.load(std::memory_order_relaxed) != sequence) {
+      return std::nullopt;
+   }
+   return event;
+}
+
+std::vector<ZoneEvent> Profiler::snapshot() const {
+   uint64_t end = m_write_index.load(std::memory_order_acquire);
+   uint64_t begin = end > kCapacity ? end - kCapacity : 0;
+
+   std::vector<ZoneEvent> events;
+   events.reserve(end - begin);
+   for(uint64_t index = begin; index < end; ++index) {
+      if(auto event = read(index)) {
+         events.push_back(*event);
+      }
+   }
+   return events;
+}
+
+std::vector<double> Profiler::recent_durations_us(std::string_view name, size_t n) const {
+   // newest first, so only the slots back to the nth match are read
+   uint64_t end = m_write_index.load(std::memory_order_acquire);
+   uint64_t begin = end > kCapacity ? end - kCapacity : 0;
+
+   std::vector<double> durations;
+   durations.reserve(n);
+   for(uint64_t index = end; (index > begin) && (durations.size() < n); --index) {
+      auto event = read(index - 1);
+      if(event && (event->name == name)) {
+         durations.push_back(event->duration_us());
+      }
+   }
+   std::reverse(durations.begin(), durations.end());
+   return durations;
+}
+
+std::vector<ZoneStats> Profiler::summarize() const {
+   std::map<std::string_view, std::vector<double>> by_name;
+   for(auto const& event : snapshot()) {
+      by_name[event.name].push_back(event.duration_us());
+   }
+
+   std::vector<ZoneStats> stats;
+   for(auto& [name, durations] : by_name) {
+      std::sort(durations.begin(), durations.end());
+      stats.push_back(ZoneStats{
+         .name = name,
+         .count = durations.size(),
+         .p50_us = PercentileOfSorted(durations, 50),
+         .p99_us = PercentileOfSorted(durations, 99),
+      });
+   }
+   return stats;
+}
+
+void Profiler::write_chrome_trace(std::ostream& out) const {
+   out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+   bool first = true;
+   for(auto const& event : snapshot()) {
+      if(!first) {
+         out << ",\n";
+      }
+      first = false;
+      // zone names are string literals from the source, no escaping needed
+      out << std::format(
+         "{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+         event.name,
+         event.thread,
+         static_cast<double>(event.start_ns) / 1000.0,
+         event.duration_us()
+      );
+   }
+   out << "\n]}\n";
+}
+
+} // namespace profiler
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+namespace profiler {
+
+/// @brief One completed timing zone. Times are nanoseconds since the profiler
+/// was created.
+struct ZoneEvent {
+   char const* name;
+   uint64_t start_ns;
+   uint64_t end_ns;
+   uint32_t thread;
+
+   double duration_us() const {
+      return static_cast<double>(end_ns - start_ns) / 1000.0;
+   }
+};
+
+struct ZoneStats {
+   std::string_view name;
+   size_t count;
+   double p50_us;
+   double p99_us;
+};
+
+/// @brief Fixed size ring buffer of the most recent zone events.
+///
+/// Recording is lock-free and may happen from any thread: a writer claims a
+/// slot with a single fetch_add and publishes it with a per-slot sequence
+/// number. Readers skip slots that are being overwritten.
+class Profiler {
+public:
+   static constexpr size_t kCapacity = size_t{1} << 16;
+
+   static Profiler& get();
+
+   uint64_t now_ns() const;
+   void record(char const* name, uint64_t start_ns, uint64_t end_ns);
+
+   /// @brief Copy of every complete event currently in the buffer, oldest first
+   std::vector<ZoneEvent> snapshot() const;
+
+   /// @brief Durations of the most recent n events of the named zone, oldest
+   /// first. Only reads back as far as the nth match, so it is cheap enough to
+   /// call every frame.
+   std::vector<double> recent_durations_us(std::string_view name, size_t n) const;
+
+   /// @brief p50/p99 per zone name over the whole buffer, sorted by name
+   std::vector<ZoneStats> summarize() const;
+
+   /// @brief Writes the buffer in the Chrome trace event format, loadable by
+   /// chrome://tracing or Perfetto
+   void write_chrome_trace(std::ostream& out) const;
+
+private:
+   Profiler();
+
+   struct Slot {
+      // 0 while being written, otherwise index + 1 of the event it holds
+      std::atomic<uint64_t> sequence{0};
+      std::atomic<char const*> name{nullptr};
+      std::atomic<uint64_t> start_ns{0};
+      std::atomic<uint64_t> end_ns{0};
+      std::atomic<uint32_t> thread{0};
+   };
+
+   /// @brief The event at index, nullopt if its slot is being written or
+   /// already holds a newer event
+   std::optional<ZoneEvent> read(uint64_t index) const;
+
+   std::atomic<uint64_t> m_write_index{0};
+   std::array<Slot, kCapacity> m_slots;
+   int64_t m_epoch_ns;
+};
+
+/// @brief Records the lifetime of this object as a zone. name must have static
+/// storage duration.
+class ScopedZone {
+public:
+   explicit ScopedZone(char const* name) :
+      m_name(name),
+      m_start_ns(Profiler::get().now_ns()) {}
+   ~ScopedZone() {
+      Profiler::get().record(m_name, m_start_ns, Profiler::get().now_ns());
+   }
+   ScopedZone(ScopedZone const&) = delete;
+   ScopedZone& operator=(ScopedZone const&) = delete;
+
+private:
+   char const* m_name;
+   uint64_t m_start_ns;
+};
+
+} // namespace profiler
+
+#define PROFILE_ZONE_CONCAT_INNER(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) \
+   ::profiler::ScopedZone PROFILE_ZONE_CONCAT(profile_zone_, __LINE__)(name)
@@ -0,0 +1,132 @@
+#include "perf/replay.hpp"
+
+#include "controller.hpp"
+#include "input.hpp"
+#include "perf/alloc_tracker.hpp"
+#include "perf/latency_histogram.hpp"
+#include "view/MonoFont.hpp"
+#include "view/view.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double MicrosecondsSince(Clock::time_point start) {
+   return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+int RunReplay(ReplayOptions const& options) {
+   std::ifstream file(options.path, std::ios::binary);
+   if(!file) {
+      std::cerr << "cannot open replay file " << options.path << "\n";
+      return 1;
+   }
+   if(options.alloc_budget.has_value() && !alloc_tracker::kEnabled) {
+      std::cerr << "--alloc-budget needs a build with -DCALC_TRACK_ALLOCATIONS=ON\n";
+      return 1;
+   }
+
+   std::vector<InputEvent> events;
+   while(auto event = ReadInputEvent(file)) {
+      events.push_back(std::move(*event));
+   }
+   if(events.empty()) {
+      std::cerr << "no events in " << options.path << "\n";
+      return 1;
+   }
+
+   Controller controller;
+   std::unique_ptr<View> view;
+   if(!options.headless) {
+      SetTraceLogLevel(LOG_WARNING);
+      SetConfigFlags(FLAG_WINDOW_HIDDEN);
+      InitWindow(850, 450, "claculator replay");
+      // never throttle, we want the raw cost of every frame
+      SetTargetFPS(0);
+      MonoFont::get().load();
+      view = std::make_unique<View>(controller);
+   }
+
+   LatencyHistogram event_hist("event handling");
+   LatencyHistogram execute_hist("reparse + execute");
+   LatencyHistogram render_hist("render");
+   LatencyHistogram frame_hist("input to frame");
+   LatencyHistogram alloc_hist("allocations per input frame", "allocs");
+   alloc_tracker::Snapshot alloc_totals;
+   size_t frames_over_budget = 0;
+
+   size_t i = 0;
+   for(size_t frame_index = 0; i < events.size(); ++frame_index) {
+      // all events of one recorded frame are handled before rendering, just
+      // like the interactive loop
+      uint64_t frame = events[i].frame;
+      auto allocs_before = alloc_tracker::TakeSnapshot();
+      auto frame_start = Clock::now();
+      for(; (i < events.size()) && (events[i].frame == frame); ++i) {
+         auto start = Clock::now();
+         controller.OnInputEvent(events[i]);
+         event_hist.add(MicrosecondsSince(start));
+      }
+      auto execute_start = Clock::now();
+      controller.FlushPendingExecution();
+      execute_hist.add(MicrosecondsSince(execute_start));
+
+      if(view) {
+         auto render_start = Clock::now();
+         BeginDrawing();
+         view->render();
+         EndDrawing();
+         render_hist.add(MicrosecondsSince(render_start));
+      }
+      frame_hist.add(MicrosecondsSince(frame_start));
+
+      auto allocs = alloc_tracker::TakeSnapshot().since(allocs_before);
+      for(size_t phase = 0; phase < allocs.phases.size(); ++phase) {
+         alloc_totals.phases[phase].allocations += allocs.phases[phase].allocations;
+         alloc_totals.phases[phase].bytes += allocs.phases[phase].bytes;
+      }
+      auto frame_allocs = allocs.total().allocations;
+      alloc_hist.add(static_cast<double>(frame_allocs));
+      if(options.alloc_budget.has_value() && (frame_index >= options.warmup_frames) &&
+         (frame_allocs > *options.alloc_budget)) {
+         ++frames_over_budget;
+         std::cerr << "frame " << frame << ": " << frame_allocs << " allocations, budget is "
+                   << *options.alloc_budget << "\n";
+      }
+   }
+
+   if(view) {
+      view.reset();
+      MonoFont::get().unload();
+      CloseWindow();
+   }
+
+   std::cout << "replayed " << events.size() << " events from " << options.path << "\n";
+   event_hist.report(std::cout);
+   execute_hist.report(std::cout);
+   if(!options.headless) {
+      render_hist.report(std::cout);
+   }
+   frame_hist.report(std::cout);
+
+   if(!alloc_tracker::kEnabled) {
+      return 0;
+   }
+   alloc_hist.report(std::cout);
+   auto frames = static_cast<double>(alloc_hist.count());
+   for(size_t phase = 0; phase < alloc_totals.phases.size(); ++phase) {
+      auto const& counts = alloc_totals.phases[phase];
+      std::cout << "  " << alloc_tracker::PhaseName(static_cast<alloc_tracker::Phase>(phase))
+                << ": " << counts.allocations << " allocs, " << counts.bytes << " bytes, "
+                << static_cast<double>(counts.allocations) / frames << " allocs/frame\n";
+   }
+   if(frames_over_budget > 0) {
+      std::cerr << frames_over_budget << " input frames exceeded the allocation budget\n";
+      return 2;
+   }
+   return 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+struct ReplayOptions {
+   std::string path;
+   /// @brief Only drive the controller, without creating a window or rendering
+   bool headless = false;
+   /// @brief Fail if any input frame after the warmup allocates more than this.
+   /// All events recorded in one frame are counted together, like the
+   /// interactive loop handles them.
+   /// Requires a build with CALC_TRACK_ALLOCATIONS.
+   std::optional<uint64_t> alloc_budget;
+   /// @brief Number of input frames excluded from the allocation budget while
+   /// caches and buffers grow to their steady state size
+   size_t warmup_frames = 10;
+};
+
+/// @brief Replays a recorded input session (see main --record) as fast as
+/// possible and prints latency histograms for event handling, reparse and
+/// execution, and rendering, plus allocation counts per input frame when
+/// allocation tracking is compiled in. Returns the process exit code, which is
+/// 2 if the allocation budget was exceeded.
+int RunReplay(ReplayOptions const& options);
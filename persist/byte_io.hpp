@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace persist {
+
+/// @brief Appends trivially copyable values to a byte buffer in host byte
+/// order. Snapshots are only read back on the machine that wrote them.
+class ByteWriter {
+public:
+   template <typename T> void put(T value) {
+      static_assert(std::is_trivially_copyable_v<T>);
+      auto const* raw = reinterpret_cast<uint8_t const*>(&value);
+      m_bytes.insert(m_bytes.end(), raw, raw + sizeof(T));
+   }
+
+   void put_bytes(void const* data, size_t size) {
+      auto const* raw = static_cast<uint8_t const*>(data);
+      m_bytes.insert(m_bytes.end(), raw, raw + size);
+   }
+
+   void append(ByteWriter const& other) {
+      put_bytes(other.m_bytes.data(), other.m_bytes.size());
+   }
+
+   size_t size() const {
+      return m_bytes.size();
+   }
+
+   void clear() {
+      m_bytes.clear();
+   }
+
+   std::vector<uint8_t> const& bytes() const {
+      return m_bytes;
+   }
+
+private:
+   std::vector<uint8_t> m_bytes;
+};
+
+/// @brief Reads values written by ByteWriter. Reading past the end returns
+/// zeroes and clears ok(), so a truncated file is checked once at the end
+/// instead of after every field.
+class ByteReader {
+public:
+   explicit ByteReader(std::span<uint8_t const> bytes) : m_bytes(bytes) {}
+
+   template <typename T> T get() {
+      static_assert(std::is_trivially_copyable_v<T>);
+      T value{};
+      if(remaining() < sizeof(T)) {
+         m_ok = false;
+         m_pos = m_bytes.size();
+         return value;
+      }
+      std::memcpy(&value, m_bytes.data() + m_pos, sizeof(T));
+      m_pos += sizeof(T);
+      return value;
+   }
+
+   std::span<uint8_t const> get_bytes(size_t size) {
+      if(remaining() < size) {
+         m_ok = false;
+         m_pos = m_bytes.size();
+         return {};
+      }
+      auto ret = m_bytes.subspan(m_pos, size);
+      m_pos += size;
+      return ret;
+   }
+
+   size_t remaining() const {
+      return m_bytes.size() - m_pos;
+   }
+
+   bool ok() const {
+      return m_ok;
+   }
+
+private:
+   std::span<uint8_t const> m_bytes;
+   size_t m_pos = 0;
+   bool m_ok = true;
+};
+
+/// @brief Strings stored once in a contiguous blob and referenced by offset
+class StringPool {
+public:
+   struct Ref {
+      uint32_t offset;
+      uint32_t length;
+   };
+
+   Ref add(std::string_view str) {
+      Ref ref{static_cast<uint32_t>(m_data.size()), static_cast<uint32_t>(str.size())};
+      m_data.insert(m_data.end(), str.begin(), str.end());
+      return ref;
+   }
+
+   size_t size() const {
+      return m_data.size();
+   }
+
+   char const* data() const {
+      return m_data.data();
+   }
+
+   void clear() {
+      m_data.clear();
+   }
+
+private:
+   std::vector<char> m_data;
+};
+
+/// @brief Resolves a StringPool::Ref against a pool that was read back from
+/// disk. Returns false if the reference is out of bounds.
+inline bool ResolveString(
+   std::span<uint8_t const> pool, StringPool::Ref ref, std::string_view& out
+) {
+   if((static_cast<size_t>(ref.offset) + ref.length) > pool.size()) {
+      return false;
+   }
+   out = std::string_view(reinterpret_cast<char const*>(pool.data()) + ref.offset, ref.length);
+   return true;
+}
+
+} // namespace persist
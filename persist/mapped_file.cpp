@@ -0,0 +1,60 @@
+#include "persist/mapped_file.hpp"
+
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CALC_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define CALC_HAVE_MMAP 0
+#endif
+
+namespace persist {
+
+MappedFile::MappedFile(std::string const& path) {
+#if CALC_HAVE_MMAP
+   int fd = ::open(path.c_str(), O_RDONLY);
+   if(fd < 0) {
+      return;
+   }
+   struct stat info{};
+   if((::fstat(fd, &info) == 0) && (info.st_size > 0)) {
+      void* mapping =
+         ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      if(mapping != MAP_FAILED) {
+         m_data = static_cast<uint8_t const*>(mapping);
+         m_size = static_cast<size_t>(info.st_size);
+         m_mapped = true;
+         m_open = true;
+      }
+   }
+   // the mapping stays valid after the descriptor is closed
+   ::close(fd);
+   if(m_open) {
+      return;
+   }
+#endif
+   std::ifstream file(path, std::ios::binary);
+   if(!file) {
+      return;
+   }
+   m_fallback.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+   m_data = m_fallback.data();
+   m_size = m_fallback.size();
+   m_open = true;
+}
+
+MappedFile::~MappedFile() {
+#if CALC_HAVE_MMAP
+   if(m_mapped) {
+      // munmap takes a non-const pointer but does not write through it
+      ::munmap(const_cast<void*>(static_cast<void const*>(m_data)), m_size);
+   }
+#endif
+}
+
+} // namespace persist
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace persist {
+
+/// @brief Read-only view of a whole file. Memory mapped on POSIX systems,
+/// elsewhere the file is read into a buffer.
+class MappedFile {
+public:
+   explicit MappedFile(std::string const& path);
+   ~MappedFile();
+   MappedFile(MappedFile const&) = delete;
+   MappedFile& operator=(MappedFile const&) = delete;
+
+   /// @brief False if the file does not exist or could not be read
+   bool is_open() const {
+      return m_open;
+   }
+
+   std::span<uint8_t const> bytes() const {
+      return {m_data, m_size};
+   }
+
+private:
+   uint8_t const* m_data = nullptr;
+   size_t m_size = 0;
+   bool m_open = false;
+   bool m_mapped = false;
+   std::vector<uint8_t> m_fallback;
+};
+
+} // namespace persist
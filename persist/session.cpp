@@ -0,0 +1,424 @@
+#include "persist/session.hpp"
+
+#include "calc/bitset.hpp"
+#include "controller.hpp"
+#include "persist/mapped_file.hpp"
+#include "raylib.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+using persist::ByteReader;
+using persist::ByteWriter;
+using persist::StringPool;
+
+namespace session {
+
+static constexpr char const* kFileName = "claculator_session.bin";
+static constexpr char const* kHistoryFileName = "claculator_history.log";
+
+static constexpr uint32_t kMagic = 0x53534c43; // "CLSS"
+static constexpr uint32_t kVersion = 1;
+
+enum class SectionId : uint32_t {
+   kModes = 1,
+   kStack = 2,
+   // 3 held the history before it moved to its own log
+   kRegister = 4,
+};
+
+struct FileHeader {
+   uint32_t magic;
+   uint32_t version;
+   uint32_t payload_size;
+   uint32_t compressed_size;
+};
+
+struct StackRecord {
+   uint8_t type;
+   uint8_t reserved[3];
+   /// @brief String or byte buffer length, zero for numbers
+   uint32_t length;
+   /// @brief Integer value, double bits, or string pool offset of the
+   /// string or byte buffer
+   uint64_t payload;
+};
+static_assert(sizeof(StackRecord) == 16);
+
+struct FieldRecord {
+   int32_t firstbit;
+   int32_t lastbit;
+   uint8_t display;
+   uint8_t reserved[3];
+   StringPool::Ref name;
+};
+
+struct ModesRecord {
+   uint8_t input_display;
+   uint8_t output_display;
+   uint8_t separator;
+   uint8_t int_width;
+   uint8_t fix;
+   uint8_t fast_entry;
+   uint8_t lane_view;
+};
+
+std::string DefaultPath() {
+   return std::string(GetApplicationDirectory()) + kFileName;
+}
+
+std::string HistoryLogPath() {
+   return std::string(GetApplicationDirectory()) + kHistoryFileName;
+}
+
+static void PutSection(ByteWriter& out, SectionId id, ByteWriter const& section) {
+   out.put(static_cast<uint32_t>(id));
+   out.put(static_cast<uint32_t>(section.size()));
+   out.append(section);
+}
+
+static void PutPool(ByteWriter& out, StringPool const& pool) {
+   out.put(static_cast<uint32_t>(pool.size()));
+   out.put_bytes(pool.data(), pool.size());
+}
+
+static ByteWriter EncodeModes(Controller const& controller) {
+   ModesRecord modes{
+      .input_display = static_cast<uint8_t>(controller.input_display.mode),
+      .output_display = static_cast<uint8_t>(controller.output_display.mode),
+      .separator = static_cast<uint8_t>(controller.sep_mode.mode),
+      .int_width = static_cast<uint8_t>(controller.int_width.mode),
+      .fix = static_cast<uint8_t>(controller.fix_mode.mode),
+      .fast_entry = static_cast<uint8_t>(controller.fast_entry_mode.mode),
+      .lane_view = static_cast<uint8_t>(controller.lane_view.mode),
+   };
+   ByteWriter out;
+   out.put(modes);
+   return out;
+}
+
+static void EncodeStack(calc::Stack const& stack, ByteWriter& out) {
+   StringPool pool;
+   out.clear();
+   out.put(static_cast<uint32_t>(stack.data.size()));
+   for(auto const& value : stack.data) {
+      StackRecord record{};
+      record.type = static_cast<uint8_t>(value.type());
+      switch(value.type()) {
+      case calc::Value::Type::kInt:
+         record.payload = static_cast<uint64_t>(value.as_int());
+         break;
+      case calc::Value::Type::kDouble:
+         record.payload = std::bit_cast<uint64_t>(value.as_double());
+         break;
+      case calc::Value::Type::kString:
+      case calc::Value::Type::kBytes:
+      case calc::Value::Type::kBitset: {
+         auto payload = value.payload();
+         auto ref = pool.add(
+            std::string_view(reinterpret_cast<char const*>(payload.data()), payload.size())
+         );
+         record.length = ref.length;
+         record.payload = ref.offset;
+         break;
+      }
+      }
+      out.put(record);
+   }
+   PutPool(out, pool);
+}
+
+static void EncodeRegister(RegisterDisplay const& reg, ByteWriter& out) {
+   StringPool pool;
+   out.clear();
+   out.put(static_cast<uint32_t>(reg.fields.size()));
+   for(auto const& field : reg.fields) {
+      FieldRecord record{};
+      record.firstbit = field.firstbit;
+      record.lastbit = field.lastbit;
+      record.display = static_cast<uint8_t>(field.display);
+      record.name = pool.add(field.name);
+      out.put(record);
+   }
+   PutPool(out, pool);
+}
+
+Autosaver::Key Autosaver::KeyOf(Controller const& controller) {
+   return Key{
+      .committed = controller.state.committed_version,
+      .modes = controller.revisions.modes,
+      .reg = controller.state.committed.reg().revision,
+   };
+}
+
+void Autosaver::MarkSaved(Controller const& controller) {
+   m_saved = KeyOf(controller);
+}
+
+void Autosaver::Update(Controller const& controller) {
+   auto key = KeyOf(controller);
+   if(key == m_saved) {
+      return;
+   }
+   Write(controller);
+   m_saved = key;
+}
+
+void Autosaver::Write(Controller const& controller) {
+   if(m_stack_version != controller.state.committed_version) {
+      EncodeStack(controller.state.committed.stack(), m_stack_section);
+      m_stack_version = controller.state.committed_version;
+   }
+   auto const& reg = controller.state.committed.reg();
+   if(m_reg_revision != reg.revision) {
+      EncodeRegister(reg, m_reg_section);
+      m_reg_revision = reg.revision;
+   }
+
+   ByteWriter payload;
+   PutSection(payload, SectionId::kModes, EncodeModes(controller));
+   PutSection(payload, SectionId::kStack, m_stack_section);
+   PutSection(payload, SectionId::kRegister, m_reg_section);
+
+   int compressed_size = 0;
+   unsigned char* compressed = CompressData(
+      payload.bytes().data(), static_cast<int>(payload.size()), &compressed_size
+   );
+   if(compressed == nullptr) {
+      return;
+   }
+   FileHeader header{
+      .magic = kMagic,
+      .version = kVersion,
+      .payload_size = static_cast<uint32_t>(payload.size()),
+      .compressed_size = static_cast<uint32_t>(compressed_size),
+   };
+
+   // write a temporary file and rename it over the old snapshot, so a crash
+   // mid-write leaves the previous snapshot intact
+   std::string temp_path = m_path + ".tmp";
+   bool written = false;
+   {
+      std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+      file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+      file.write(reinterpret_cast<char const*>(compressed), compressed_size);
+      written = static_cast<bool>(file);
+   }
+   MemFree(compressed);
+
+   // a failed save only loses the session on the next startup
+   std::error_code error;
+   if(written) {
+      std::filesystem::rename(temp_path, m_path, error);
+   } else {
+      std::filesystem::remove(temp_path, error);
+   }
+}
+
+struct DecodedSession {
+   ModesRecord modes{};
+   bool have_modes = false;
+   std::vector<calc::Value> stack;
+   std::vector<Field> fields;
+};
+
+/// @brief Splits a section body into its fixed size records and trailing pool
+static bool ReadRecordsAndPool(
+   ByteReader& reader,
+   size_t record_size,
+   uint32_t& count,
+   std::span<uint8_t const>& records,
+   std::span<uint8_t const>& pool
+) {
+   count = reader.get<uint32_t>();
+   records = reader.get_bytes(static_cast<size_t>(count) * record_size);
+   auto pool_size = reader.get<uint32_t>();
+   pool = reader.get_bytes(pool_size);
+   return reader.ok();
+}
+
+static bool DecodeStack(std::span<uint8_t const> body, std::vector<calc::Value>& out) {
+   ByteReader reader(body);
+   uint32_t count = 0;
+   std::span<uint8_t const> record_bytes;
+   std::span<uint8_t const> pool;
+   if(!ReadRecordsAndPool(reader, sizeof(StackRecord), count, record_bytes, pool)) {
+      return false;
+   }
+   ByteReader records(record_bytes);
+   out.reserve(count);
+   for(uint32_t i = 0; i < count; ++i) {
+      auto record = records.get<StackRecord>();
+      switch(static_cast<calc::Value::Type>(record.type)) {
+      case calc::Value::Type::kInt:
+         out.emplace_back(static_cast<int64_t>(record.payload));
+         break;
+      case calc::Value::Type::kDouble:
+         out.emplace_back(std::bit_cast<double>(record.payload));
+         break;
+      case calc::Value::Type::kString: {
+         std::string_view str;
+         StringPool::Ref ref{static_cast<uint32_t>(record.payload), record.length};
+         if((record.payload > UINT32_MAX) || !persist::ResolveString(pool, ref, str)) {
+            return false;
+         }
+         out.emplace_back(std::string(str));
+         break;
+      }
+      case calc::Value::Type::kBytes: {
+         std::string_view str;
+         StringPool::Ref ref{static_cast<uint32_t>(record.payload), record.length};
+         if((record.payload > UINT32_MAX) || !persist::ResolveString(pool, ref, str)) {
+            return false;
+         }
+         out.emplace_back(calc::Bytes(str.begin(), str.end()));
+         break;
+      }
+      case calc::Value::Type::kBitset: {
+         std::string_view str;
+         StringPool::Ref ref{static_cast<uint32_t>(record.payload), record.length};
+         if((record.payload > UINT32_MAX) || !persist::ResolveString(pool, ref, str) ||
+            ((str.size() % sizeof(uint64_t)) != 0)) {
+            return false;
+         }
+         calc::BitWords words(str.size() / sizeof(uint64_t));
+         std::memcpy(words.data(), str.data(), str.size());
+         bitset::Trim(words);
+         out.emplace_back(std::move(words));
+         break;
+      }
+      default:
+         return false;
+      }
+   }
+   return true;
+}
+
+static bool DecodeRegister(std::span<uint8_t const> body, std::vector<Field>& out) {
+   ByteReader reader(body);
+   uint32_t count = 0;
+   std::span<uint8_t const> record_bytes;
+   std::span<uint8_t const> pool;
+   if(!ReadRecordsAndPool(reader, sizeof(FieldRecord), count, record_bytes, pool)) {
+      return false;
+   }
+   ByteReader records(record_bytes);
+   out.reserve(count);
+   for(uint32_t i = 0; i < count; ++i) {
+      auto record = records.get<FieldRecord>();
+      std::string_view name;
+      bool valid = persist::ResolveString(pool, record.name, name) && (record.firstbit >= 0) &&
+                   (record.firstbit <= record.lastbit) && (record.lastbit < 64) &&
+                   (record.display <= static_cast<uint8_t>(FieldDisplay::kEnum));
+      if(!valid) {
+         return false;
+      }
+      out.emplace_back(
+         record.firstbit,
+         record.lastbit,
+         std::string(name),
+         static_cast<FieldDisplay>(record.display)
+      );
+   }
+   return true;
+}
+
+static bool DecodePayload(std::span<uint8_t const> payload, DecodedSession& out) {
+   ByteReader reader(payload);
+   while(reader.remaining() > 0) {
+      auto id = static_cast<SectionId>(reader.get<uint32_t>());
+      auto size = reader.get<uint32_t>();
+      auto body = reader.get_bytes(size);
+      if(!reader.ok()) {
+         return false;
+      }
+      bool ok = true;
+      switch(id) {
+      case SectionId::kModes: {
+         // files from before a mode was added end before it, so it keeps its
+         // default
+         out.modes = ModesRecord{};
+         std::memcpy(&out.modes, body.data(), std::min(body.size(), sizeof(ModesRecord)));
+         out.have_modes = body.size() >= offsetof(ModesRecord, lane_view);
+         break;
+      }
+      case SectionId::kStack:
+         ok = DecodeStack(body, out.stack);
+         break;
+      case SectionId::kRegister:
+         ok = DecodeRegister(body, out.fields);
+         break;
+      default:
+         // written by an older or newer build, skip it
+         break;
+      }
+      if(!ok) {
+         return false;
+      }
+   }
+   return true;
+}
+
+template <typename T> static void RestoreMode(T& mode, uint8_t value, T max) {
+   if(value <= static_cast<uint8_t>(max)) {
+      mode = static_cast<T>(value);
+   }
+}
+
+static void ApplyModes(Controller& controller, ModesRecord const& modes) {
+   using IntBase = NumericDisplayMode::Mode;
+   RestoreMode(controller.input_display.mode, modes.input_display, IntBase::kBin);
+   RestoreMode(controller.output_display.mode, modes.output_display, IntBase::kBin);
+   RestoreMode(controller.sep_mode.mode, modes.separator, SeparatorMode::Mode::kEight);
+   RestoreMode(controller.int_width.mode, modes.int_width, IntWidthMode::Mode::k64);
+   RestoreMode(controller.fix_mode.mode, modes.fix, FixMode::Mode::kPostfix);
+   RestoreMode(controller.fast_entry_mode.mode, modes.fast_entry, FastEntryMode::Mode::kOff);
+   RestoreMode(controller.lane_view.mode, modes.lane_view, LaneViewMode::Mode::kF64);
+}
+
+bool Load(Controller& controller, std::string const& path) {
+   persist::MappedFile file(path);
+   if(!file.is_open()) {
+      return false;
+   }
+   ByteReader reader(file.bytes());
+   auto header = reader.get<FileHeader>();
+   auto compressed = reader.get_bytes(header.compressed_size);
+   if(!reader.ok() || (header.magic != kMagic) || (header.version != kVersion)) {
+      return false;
+   }
+
+   int payload_size = 0;
+   unsigned char* payload = DecompressData(
+      compressed.data(), static_cast<int>(compressed.size()), &payload_size
+   );
+   if(payload == nullptr) {
+      return false;
+   }
+   DecodedSession decoded;
+   bool valid = (static_cast<uint32_t>(payload_size) == header.payload_size) &&
+                DecodePayload({payload, static_cast<size_t>(payload_size)}, decoded);
+   MemFree(payload);
+   if(!valid) {
+      return false;
+   }
+
+   if(decoded.have_modes) {
+      ApplyModes(controller, decoded.modes);
+   }
+   auto& committed = controller.state.committed;
+   committed.set_stack(calc::Stack{std::move(decoded.stack)});
+   committed.edit_reg().SetFields(std::move(decoded.fields));
+   controller.OnSessionRestored();
+   return true;
+}
+
+} // namespace session
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "persist/byte_io.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class Controller;
+
+/// @brief Binary snapshots of the committed session state: the committed
+/// stack, display modes and register fields. History is kept separately in an
+/// append-only log, see HistoryStore.
+///
+/// The file is a small header followed by a DEFLATE compressed payload of
+/// tagged sections. Stack values are stored as a flat array of fixed size
+/// records with strings in a per-section pool, so restoring never goes through
+/// the parser. Unknown sections are skipped, a different format version is
+/// ignored and the session starts empty.
+namespace session {
+
+/// @brief Snapshot location next to the executable
+std::string DefaultPath();
+
+/// @brief History log location next to the executable
+std::string HistoryLogPath();
+
+/// @brief Restores a snapshot into a freshly constructed controller. Returns
+/// false, leaving the controller untouched, if there is no valid snapshot.
+bool Load(Controller& controller, std::string const& path);
+
+/// @brief Writes snapshots when the committed state changes. Each section is
+/// only re-encoded if the state it holds changed since the last save.
+class Autosaver {
+public:
+   explicit Autosaver(std::string path) : m_path(std::move(path)) {}
+
+   /// @brief Saves if anything was committed or a mode changed since the last
+   /// save. Cheap to call every frame.
+   void Update(Controller const& controller);
+
+   /// @brief Marks the current state as saved, used after Load so an
+   /// unchanged session is not immediately rewritten
+   void MarkSaved(Controller const& controller);
+
+private:
+   struct Key {
+      uint64_t committed = ~0ull;
+      uint64_t modes = ~0ull;
+      uint64_t reg = ~0ull;
+
+      bool operator==(Key const&) const = default;
+   };
+
+   std::string m_path;
+   Key m_saved;
+
+   uint64_t m_stack_version = ~0ull;
+   persist::ByteWriter m_stack_section;
+   uint64_t m_reg_revision = ~0ull;
+   persist::ByteWriter m_reg_section;
+
+   static Key KeyOf(Controller const& controller);
+   void Write(Controller const& controller);
+};
+
+} // namespace session
@@ -1,50 +1,202 @@
 #include "view/BitfieldDisplay.hpp"
+#include "calc/bitset.hpp"
 #include "raylib.h"
+#include "rlgl.h"
+#include "view/MonoFont.hpp"
 #include "view/style.hpp"
 #include <array>
-#include <charconv>
+#include <bit>
+#include <format>
 #include <iostream>
 
 static constexpr std::array<Color, 10> kFieldColors = {
    YELLOW, ORANGE, PINK, RED, GREEN, LIME, SKYBLUE, BLUE, PURPLE, VIOLET
 };
 
+static constexpr int kMaxBits = 64;
+
 struct BitfieldDisplayInfo {
    int bitbox_size = kDefaultStyle.tiny_font + 3;
    int spacing = 2;
    int big_spacing = 10;
 };
 
+static constexpr BitfieldDisplayInfo kInfo{
+   .bitbox_size = kDefaultStyle.tiny_font + 11,
+   .spacing = 2,
+   .big_spacing = 10,
+};
+
+using BitLabel = std::array<char, 3>;
+
+static constexpr std::array<BitLabel, kMaxBits> make_bit_labels() {
+   std::array<BitLabel, kMaxBits> labels{};
+   for(int i = 0; i < kMaxBits; ++i) {
+      if(i < 10) {
+         labels[i] = {static_cast<char>('0' + i), 0, 0};
+      } else {
+         labels[i] = {static_cast<char>('0' + i / 10), static_cast<char>('0' + i % 10), 0};
+      }
+   }
+   return labels;
+}
+
+static constexpr std::array<BitLabel, kMaxBits> kBitLabels = make_bit_labels();
+
+/// @brief Texture coordinates and offsets for every bit label, resolved once
+/// against the default font so a whole row can be emitted as a single batch of
+/// quads. The labels stay on the default bitmap font: it is pixel exact at the
+/// tiny font size and needs no SDF shader, so cells and labels can share one
+/// batch. The default font atlas also contains the white rectangle raylib uses
+/// for shapes, so cell backgrounds share the same texture.
+struct BitLabelAtlas {
+   struct Glyph {
+      Rectangle dst;
+      Rectangle uv;
+   };
+   static constexpr int kMaxGlyphs = 2;
+
+   unsigned int texture_id;
+   Rectangle white_uv;
+   std::array<std::array<Glyph, kMaxGlyphs>, kMaxBits> glyphs;
+   std::array<int, kMaxBits> glyph_counts;
+};
+
+static Rectangle to_uv(Texture2D const& texture, Rectangle rec) {
+   auto w = static_cast<float>(texture.width);
+   auto h = static_cast<float>(texture.height);
+   return Rectangle{rec.x / w, rec.y / h, rec.width / w, rec.height / h};
+}
+
+static BitLabelAtlas make_bit_label_atlas() {
+   Font font = GetFontDefault();
+   float font_size = kDefaultStyle.tiny_font;
+   float scale = font_size / font.baseSize;
+   // matches the spacing DrawText uses for the default font
+   float spacing = font_size / 10.0f;
+   float padding = font.glyphPadding;
+
+   BitLabelAtlas atlas{};
+   atlas.texture_id = font.texture.id;
+
+   // same inset as raylib's shapes texture to avoid bleeding
+   Rectangle white = font.recs[95];
+   atlas.white_uv = to_uv(
+      font.texture,
+      Rectangle{white.x + 1, white.y + 1, white.width - 2, white.height - 2}
+   );
+
+   for(int bit = 0; bit < kMaxBits; ++bit) {
+      float x = 0;
+      int count = 0;
+      for(char c : kBitLabels[bit]) {
+         if(c == 0) {
+            break;
+         }
+         int index = GetGlyphIndex(font, c);
+         Rectangle rec = font.recs[index];
+         GlyphInfo const& glyph = font.glyphs[index];
+         atlas.glyphs[bit][count] = BitLabelAtlas::Glyph{
+            .dst =
+               Rectangle{
+                  x + (glyph.offsetX - padding) * scale,
+                  (glyph.offsetY - padding) * scale,
+                  (rec.width + 2 * padding) * scale,
+                  (rec.height + 2 * padding) * scale
+               },
+            .uv = to_uv(
+               font.texture,
+               Rectangle{
+                  rec.x - padding,
+                  rec.y - padding,
+                  rec.width + 2 * padding,
+                  rec.height + 2 * padding
+               }
+            ),
+         };
+         x += ((glyph.advanceX == 0) ? rec.width : glyph.advanceX) * scale + spacing;
+         ++count;
+      }
+      atlas.glyph_counts[bit] = count;
+   }
+   return atlas;
+}
+
+static BitLabelAtlas const& bit_label_atlas() {
+   static BitLabelAtlas const atlas = make_bit_label_atlas();
+   return atlas;
+}
+
+static void emit_quad(Rectangle dst, Rectangle uv, Color color) {
+   rlColor4ub(color.r, color.g, color.b, color.a);
+   rlTexCoord2f(uv.x, uv.y);
+   rlVertex2f(dst.x, dst.y);
+   rlTexCoord2f(uv.x, uv.y + uv.height);
+   rlVertex2f(dst.x, dst.y + dst.height);
+   rlTexCoord2f(uv.x + uv.width, uv.y + uv.height);
+   rlVertex2f(dst.x + dst.width, dst.y + dst.height);
+   rlTexCoord2f(uv.x + uv.width, uv.y);
+   rlVertex2f(dst.x + dst.width, dst.y);
+}
+
 static int x_offset_of(int bit_index, BitfieldDisplayInfo const& info) {
    auto index_from_left = 31 - bit_index;
    return (info.bitbox_size + info.spacing) * index_from_left +
           info.big_spacing * (index_from_left / 8);
 }
 
-static void render_one_line(
-   int x, int y, RegisterDisplay const& display, int64_t value, int bitoffset, int bitcount,
-   BitfieldDisplayInfo const& info
-) {
+void BitfieldDisplay::update_field_labels(RegisterDisplay const& display, int64_t value) {
+   bool stale = (m_labels_display != &display) || (m_labels_revision != display.revision) ||
+                (m_labels_value != value) || (m_field_labels.size() != display.fields.size());
+   if(!stale) {
+      return;
+   }
+   m_field_labels.resize(display.fields.size());
+   for(size_t i = 0; i < display.fields.size(); ++i) {
+      display.fields[i].GetLabel(value, m_field_labels[i]);
+   }
+   m_labels_display = &display;
+   m_labels_revision = display.revision;
+   m_labels_value = value;
+}
+
+void BitfieldDisplay::render_one_line(
+   int x, int y, RegisterDisplay const& display, int64_t value, int bitoffset, int bitcount
+) const {
+   auto const& info = kInfo;
+   auto const& atlas = bit_label_atlas();
+
+   // cells and labels for the whole row go out as one batch of quads
+   rlCheckRenderBatchLimit(bitcount * 4 * (1 + BitLabelAtlas::kMaxGlyphs));
+   rlSetTexture(atlas.texture_id);
+   rlBegin(RL_QUADS);
+   rlNormal3f(0.0f, 0.0f, 1.0f);
    for(int i = 0; i < bitcount; ++i) {
       int bit_index = (bitcount - i - 1) + bitoffset;
       bool bit_set = value & (1ull << bit_index);
       Color bg = bit_set ? kDefaultStyle.light_bg : kDefaultStyle.dark_bg;
       Color fg = bit_set ? kDefaultStyle.light_text : kDefaultStyle.dark_text;
 
-      int x_offset = x_offset_of(bit_index - bitoffset, info);
-
-      DrawRectangle(x + x_offset, y, info.bitbox_size, info.bitbox_size, bg);
+      float cell_x = x + x_offset_of(bit_index - bitoffset, info);
+      float cell_y = y;
+      float size = info.bitbox_size;
+      emit_quad(Rectangle{cell_x, cell_y, size, size}, atlas.white_uv, bg);
 
-      std::array<char, 10> buf{};
-      std::to_chars(&*buf.begin(), (&*buf.begin()) + buf.size(), bit_index, 10);
-      DrawText(
-         &*buf.begin(),
-         x + x_offset + info.bitbox_size / 2 - kDefaultStyle.tiny_font / 2,
-         y + info.bitbox_size / 2 - kDefaultStyle.tiny_font / 2,
-         kDefaultStyle.tiny_font,
-         fg
-      );
+      float label_x = cell_x + info.bitbox_size / 2 - kDefaultStyle.tiny_font / 2;
+      float label_y = cell_y + info.bitbox_size / 2 - kDefaultStyle.tiny_font / 2;
+      for(int g = 0; g < atlas.glyph_counts[bit_index]; ++g) {
+         auto const& glyph = atlas.glyphs[bit_index][g];
+         emit_quad(
+            Rectangle{
+               label_x + glyph.dst.x, label_y + glyph.dst.y, glyph.dst.width, glyph.dst.height
+            },
+            glyph.uv,
+            fg
+         );
+      }
    }
+   rlEnd();
+   rlSetTexture(0);
 
    for(size_t i = 0; i < display.fields.size(); ++i) {
       auto const& field = display.fields[i];
@@ -65,9 +217,8 @@ static void render_one_line(
       DrawRectangleLines(x + last_offset - 1, y, width, info.bitbox_size + 2, color);
 
       int text_row = last_clipped % 4;
-      auto string = field.name + "=" + field.GetDisplay(value);
-      DrawText(
-         string.c_str(),
+      MonoFont::get().draw(
+         m_field_labels[i],
          x + last_offset,
          y + text_row * kDefaultStyle.small_font + info.bitbox_size + 2,
          kDefaultStyle.small_font,
@@ -77,20 +228,85 @@ static void render_one_line(
 }
 
 void BitfieldDisplay::render(int x, int y, RegisterDisplay const& display, int64_t value) {
-   auto info = BitfieldDisplayInfo{
-      .bitbox_size = kDefaultStyle.tiny_font + 11,
-      .spacing = 2,
-      .big_spacing = 10,
-   };
+   auto const& info = kInfo;
+   update_field_labels(display, value);
 
-   render_one_line(x + 1, y, display, value, 32, 32, info);
+   render_one_line(x + 1, y, display, value, 32, 32);
    render_one_line(
       x + 1,
       y + info.bitbox_size + 2 + (display.fields.empty() ? 0 : 100),
       display,
       value,
       0,
-      32,
-      info
+      32
    );
-}
\ No newline at end of file
+}
+
+/// @brief More runs than fit across the widest window
+static constexpr size_t kMaxDrawnRuns = 128;
+
+void BitfieldDisplay::render_runs(int x, int y, int width, std::span<uint64_t const> words) const {
+   auto const& info = kInfo;
+   auto const& font = MonoFont::get();
+   size_t run_count = bitset::RunCount(words);
+   // room for the "+N" after the last cell that fits
+   int right = x + width - font.measure(6, kDefaultStyle.small_font);
+
+   int cell_x = x;
+   size_t drawn = 0;
+   auto draw_cell = [&](size_t first, size_t last, bool set) {
+      auto label = (first == last) ? std::to_string(first) : std::format("{}-{}", first, last);
+      int cell_width = font.measure(label, kDefaultStyle.tiny_font) + 8;
+      if(cell_x + cell_width > right) {
+         return false;
+      }
+      DrawRectangle(
+         cell_x,
+         y,
+         cell_width,
+         info.bitbox_size,
+         set ? kDefaultStyle.light_bg : kDefaultStyle.dark_bg
+      );
+      font.draw(
+         label,
+         cell_x + 4,
+         y + info.bitbox_size / 2 - kDefaultStyle.tiny_font / 2,
+         kDefaultStyle.tiny_font,
+         set ? kDefaultStyle.light_text : kDefaultStyle.dark_text
+      );
+      cell_x += cell_width + info.spacing;
+      return true;
+   };
+
+   size_t next_clear = 0;
+   for(auto const& run : bitset::Runs(words, kMaxDrawnRuns)) {
+      if((run.first > next_clear) && !draw_cell(next_clear, run.first - 1, false)) {
+         break;
+      }
+      if(!draw_cell(run.first, run.last, true)) {
+         break;
+      }
+      next_clear = run.last + 1;
+      ++drawn;
+   }
+   if(drawn < run_count) {
+      font.draw(
+         std::format("+{}", run_count - drawn),
+         cell_x,
+         y + info.bitbox_size / 2 - kDefaultStyle.small_font / 2,
+         kDefaultStyle.small_font,
+         kDefaultStyle.dark_text
+      );
+   }
+
+   size_t highest = words.size() * 64 - static_cast<size_t>(std::countl_zero(words.back())) - 1;
+   font.draw(
+      std::format(
+         "{} bits set in {} runs, highest {}", bitset::PopCount(words), run_count, highest
+      ),
+      x,
+      y + info.bitbox_size + info.spacing,
+      kDefaultStyle.small_font,
+      kDefaultStyle.dark_text
+   );
+}
@@ -2,12 +2,34 @@
 
 #include "calc/bit_register.hpp"
 
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
 class BitfieldDisplay {
 public:
    static int height(RegisterDisplay const& display) {
       return display.fields.empty() ? 45 : 250;
    }
-   static void render(
+   void render(
       int x, int y, RegisterDisplay const& display, int64_t value
    );
-};
\ No newline at end of file
+   /// @brief A bitset too wide for a cell per bit: one cell per run of equal
+   /// bits from bit 0 on the left, like its range list, as many as fit in
+   /// width, and a summary line below
+   void render_runs(int x, int y, int width, std::span<uint64_t const> words) const;
+
+private:
+   /// @brief "name=value" for each field, only rebuilt when the displayed
+   /// value or the field list changes
+   std::vector<std::string> m_field_labels;
+   RegisterDisplay const* m_labels_display = nullptr;
+   uint64_t m_labels_revision = 0;
+   int64_t m_labels_value = 0;
+
+   void update_field_labels(RegisterDisplay const& display, int64_t value);
+   void render_one_line(
+      int x, int y, RegisterDisplay const& display, int64_t value, int bitoffset, int bitcount
+   ) const;
+};
@@ -0,0 +1,58 @@
+#include "view/CachedPanel.hpp"
+
+CachedPanel::~CachedPanel() {
+   unload();
+}
+
+void CachedPanel::unload() {
+   // the GL context is already gone if the window was closed first
+   if((m_texture.id != 0) && IsWindowReady()) {
+      UnloadRenderTexture(m_texture);
+   }
+   m_texture = RenderTexture2D{};
+}
+
+void CachedPanel::track(std::uint64_t key, Rectangle bounds) {
+   bool resized = (bounds.width != m_bounds.width) || (bounds.height != m_bounds.height);
+   bool moved = (bounds.x != m_bounds.x) || (bounds.y != m_bounds.y);
+   if(resized) {
+      unload();
+      if((bounds.width >= 1) && (bounds.height >= 1)) {
+         m_texture =
+            LoadRenderTexture(static_cast<int>(bounds.width), static_cast<int>(bounds.height));
+      }
+   }
+   if(resized || moved || (key != m_key)) {
+      m_dirty = true;
+   }
+   m_bounds = bounds;
+   m_key = key;
+}
+
+void CachedPanel::begin() {
+   BeginTextureMode(m_texture);
+   ClearBackground(BLANK);
+   Camera2D camera{};
+   camera.offset = Vector2{-m_bounds.x, -m_bounds.y};
+   camera.zoom = 1.0f;
+   BeginMode2D(camera);
+}
+
+void CachedPanel::end() {
+   EndMode2D();
+   EndTextureMode();
+   m_dirty = false;
+}
+
+void CachedPanel::draw() const {
+   if(m_texture.id == 0) {
+      return;
+   }
+   // render textures are stored upside down, flip the source rect
+   DrawTextureRec(
+      m_texture.texture,
+      Rectangle{0, 0, m_bounds.width, -m_bounds.height},
+      Vector2{m_bounds.x, m_bounds.y},
+      WHITE
+   );
+}
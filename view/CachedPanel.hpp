@@ -0,0 +1,59 @@
+#pragma once
+
+#include "raylib.h"
+
+#include <cstdint>
+
+/// @brief A screen region that is rendered into an offscreen texture and only
+/// re-rendered when its contents change.
+///
+/// Usage per frame:
+///    panel.track(key, bounds);
+///    if(panel.dirty()) { panel.begin(); ...draw in screen coords...; panel.end(); }
+///    panel.draw();
+class CachedPanel {
+public:
+   CachedPanel() = default;
+   ~CachedPanel();
+   CachedPanel(CachedPanel const&) = delete;
+   CachedPanel& operator=(CachedPanel const&) = delete;
+
+   /// @brief Marks the panel dirty if the key or the panel bounds changed since
+   /// the last call. The key should be a combination of every revision counter
+   /// the panel's contents depend on.
+   void track(std::uint64_t key, Rectangle bounds);
+
+   void invalidate() {
+      m_dirty = true;
+   }
+
+   bool dirty() const {
+      return m_dirty;
+   }
+
+   /// @brief Start drawing into the panel texture. Drawing uses screen
+   /// coordinates, they are offset into the panel automatically.
+   void begin();
+   void end();
+
+   /// @brief Draw the cached texture at the panel bounds.
+   void draw() const;
+
+private:
+   RenderTexture2D m_texture{};
+   Rectangle m_bounds{};
+   std::uint64_t m_key = 0;
+   bool m_dirty = true;
+
+   void unload();
+};
+
+/// @brief Combine revision counters into a single key for CachedPanel::track
+constexpr std::uint64_t combine_revisions(std::uint64_t a, std::uint64_t b) {
+   return (a * 0x9E3779B97F4A7C15ull) ^ (b + 0x7F4A7C159E3779B9ull + (a << 6) + (a >> 2));
+}
+
+template <typename... Rest>
+constexpr std::uint64_t combine_revisions(std::uint64_t a, std::uint64_t b, Rest... rest) {
+   return combine_revisions(combine_revisions(a, b), rest...);
+}
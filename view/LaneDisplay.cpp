@@ -0,0 +1,103 @@
+#include "view/LaneDisplay.hpp"
+#include "calc/bit_ops.hpp"
+#include "raylib.h"
+#include "view/MonoFont.hpp"
+#include "view/style.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <format>
+#include <string>
+
+static constexpr size_t kRowBytes = 16;
+/// @brief Room for the widest value of any lane, e.g. -128 in one byte
+static constexpr int kCharsPerByte = 4;
+static constexpr int kSpacing = 2;
+static constexpr int kRowHeight = kDefaultStyle.tiny_font + kDefaultStyle.small_font + 8;
+
+int LaneDisplay::height() {
+   return 2 * (kRowHeight + kSpacing);
+}
+
+static std::string format_lane(lanes::Lane lane, uint8_t const* bytes, intbase::IntBase base) {
+   if(lane == lanes::Lane::kF32) {
+      float value = 0;
+      std::memcpy(&value, bytes, sizeof(value));
+      return std::format("{:g}", value);
+   }
+   if(lane == lanes::Lane::kF64) {
+      double value = 0;
+      std::memcpy(&value, bytes, sizeof(value));
+      return std::format("{:g}", value);
+   }
+   size_t size = lanes::LaneBytes(lane);
+   uint64_t bits = 0;
+   std::memcpy(&bits, bytes, size);
+   if(base != intbase::IntBase::kDec) {
+      return std::format("{:x}", bits);
+   }
+   if(lanes::IsSigned(lane)) {
+      return std::format("{}", bitops::SignExtend(bits, static_cast<int>(size * 8)));
+   }
+   return std::format("{}", bits);
+}
+
+void LaneDisplay::render(
+   int x, int y, lanes::Lane lane, calc::Value const* value, intbase::IntBase base
+) const {
+   auto const& font = MonoFont::get();
+   std::array<uint8_t, lanes::kMaxVectorBytes> vector{};
+   size_t size = 0;
+   if((value != nullptr) && (value->type() == calc::Value::Type::kInt)) {
+      int64_t bits = value->as_int();
+      std::memcpy(vector.data(), &bits, sizeof(bits));
+      size = sizeof(bits);
+   } else if((value != nullptr) && (value->type() == calc::Value::Type::kBytes) &&
+             lanes::IsVectorSize(value->as_bytes().size())) {
+      std::ranges::copy(value->as_bytes(), vector.begin());
+      size = value->as_bytes().size();
+   }
+   if(size == 0) {
+      font.draw(
+         "lanes of an int or of 8, 16 or 32 bytes",
+         x,
+         y,
+         kDefaultStyle.small_font,
+         kDefaultStyle.dark_text
+      );
+      return;
+   }
+
+   int byte_width = font.measure(kCharsPerByte, kDefaultStyle.small_font);
+   size_t lane_bytes = lanes::LaneBytes(lane);
+   size_t row_bytes = std::min(size, kRowBytes);
+   size_t rows = size / row_bytes;
+   for(size_t row = 0; row < rows; ++row) {
+      size_t block = (rows - 1 - row) * row_bytes;
+      int row_y = y + static_cast<int>(row) * (kRowHeight + kSpacing);
+      for(size_t offset = 0; offset < row_bytes; offset += lane_bytes) {
+         int cell_x = x + static_cast<int>(row_bytes - offset - lane_bytes) * byte_width;
+         int cell_width = static_cast<int>(lane_bytes) * byte_width - kSpacing;
+         DrawRectangle(cell_x, row_y, cell_width, kRowHeight, kDefaultStyle.dark_bg);
+
+         size_t index = (block + offset) / lane_bytes;
+         font.draw(
+            std::to_string(index),
+            cell_x + 2,
+            row_y + 2,
+            kDefaultStyle.tiny_font,
+            kDefaultStyle.dark_text
+         );
+         // right aligned, so the digits of a row of ints line up
+         auto text = format_lane(lane, vector.data() + block + offset, base);
+         font.draw(
+            text,
+            cell_x + cell_width - font.measure(text, kDefaultStyle.small_font) - 2,
+            row_y + kDefaultStyle.tiny_font + 4,
+            kDefaultStyle.small_font,
+            kDefaultStyle.dark_text_emphasis
+         );
+      }
+   }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "calc/intbase.hpp"
+#include "calc/lanes.hpp"
+#include "calc/value.hpp"
+
+/// @brief The top of the stack as the lanes of a 64, 128 or 256-bit vector,
+/// the operands of the lane words. Each 128 bits is a row with lane 0 on the
+/// right, like bit 0 in the bit display, and the high half of a 256-bit
+/// vector on top.
+class LaneDisplay {
+public:
+   static int height();
+   /// @brief value is null for an empty stack. Ints are shown in base,
+   /// except that binary would not fit a lane and shows hex.
+   void render(
+      int x, int y, lanes::Lane lane, calc::Value const* value, intbase::IntBase base
+   ) const;
+};
@@ -0,0 +1,287 @@
+#include "view/MonoFont.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifndef CALC_FONT_PATH
+#define CALC_FONT_PATH "anonymous_pro_bold.ttf"
+#endif
+
+static constexpr int kBaseSize = 32;
+static constexpr int kGlyphCount = 95; // printable ascii, starting at ' '
+static constexpr char const* kCacheFileName = "claculator_font.cache";
+
+static constexpr uint32_t kCacheMagic = 0x544e4643; // "CFNT"
+static constexpr uint32_t kCacheVersion = 1;
+/// @brief Larger atlas sides in a cache header are taken as corruption
+static constexpr int kMaxAtlasSide = 8192;
+
+// Default raylib vertex shader is used, this only computes coverage from the
+// distance field.
+static constexpr char const* kSdfFragmentShader = R"(#version 330
+in vec2 fragTexCoord;
+in vec4 fragColor;
+uniform sampler2D texture0;
+uniform vec4 colDiffuse;
+out vec4 finalColor;
+void main() {
+   float dist = texture(texture0, fragTexCoord).a - 0.5;
+   float delta = length(vec2(dFdx(dist), dFdy(dist)));
+   float alpha = smoothstep(-delta, delta, dist);
+   finalColor = vec4(fragColor.rgb, fragColor.a * alpha);
+}
+)";
+
+struct CacheHeader {
+   uint32_t magic;
+   uint32_t version;
+   int64_t source_mod_time;
+   int32_t base_size;
+   int32_t glyph_count;
+   int32_t glyph_padding;
+   int32_t atlas_width;
+   int32_t atlas_height;
+   int32_t atlas_format;
+   int32_t atlas_data_size;
+};
+
+struct CacheGlyph {
+   int32_t value;
+   int32_t offset_x;
+   int32_t offset_y;
+   int32_t advance_x;
+   Rectangle rec;
+};
+
+MonoFont& MonoFont::get() {
+   static MonoFont font;
+   return font;
+}
+
+void MonoFont::load() {
+   if(m_loaded) {
+      return;
+   }
+   std::string cache_path = std::string(GetApplicationDirectory()) + kCacheFileName;
+   // CALC_FONT_PATH is in the source tree. Away from it, e.g. when the
+   // executable is shipped with its cache, the cache cannot be re-baked and
+   // is used whatever TTF it was baked from.
+   std::optional<long> mod_time;
+   if(FileExists(CALC_FONT_PATH)) {
+      mod_time = GetFileModTime(CALC_FONT_PATH);
+   }
+
+   bool have_sdf_atlas = load_from_cache(cache_path.c_str(), mod_time);
+   if(!have_sdf_atlas && mod_time.has_value()) {
+      have_sdf_atlas = bake_from_ttf(CALC_FONT_PATH, cache_path.c_str(), *mod_time);
+   }
+
+   if(have_sdf_atlas) {
+      m_shader = LoadShaderFromMemory(nullptr, kSdfFragmentShader);
+      if(IsShaderReady(m_shader)) {
+         SetTextureFilter(m_font.texture, TEXTURE_FILTER_BILINEAR);
+         m_is_sdf = true;
+      } else {
+         UnloadFont(m_font);
+      }
+   }
+
+   if(!m_is_sdf) {
+      m_font = GetFontDefault();
+   }
+   finish_load();
+}
+
+void MonoFont::finish_load() {
+   int index = GetGlyphIndex(m_font, 'M');
+   float advance = m_font.glyphs[index].advanceX;
+   if(advance == 0) {
+      // the default font has no advances, it is laid out from the glyph rects
+      advance = m_font.recs[index].width + 1;
+   }
+   m_advance = advance / static_cast<float>(m_font.baseSize);
+   m_loaded = true;
+}
+
+void MonoFont::unload() {
+   if(!m_loaded) {
+      return;
+   }
+   if(m_is_sdf) {
+      UnloadShader(m_shader);
+      UnloadFont(m_font);
+   }
+   m_font = Font{};
+   m_is_sdf = false;
+   m_loaded = false;
+}
+
+bool MonoFont::bake_from_ttf(
+   char const* ttf_path, char const* cache_path, long source_mod_time
+) {
+   int size = 0;
+   unsigned char* data = LoadFileData(ttf_path, &size);
+   if(data == nullptr) {
+      return false;
+   }
+
+   Font font{};
+   font.baseSize = kBaseSize;
+   font.glyphCount = kGlyphCount;
+   font.glyphPadding = 0;
+   font.glyphs = LoadFontData(data, size, kBaseSize, nullptr, kGlyphCount, FONT_SDF);
+   UnloadFileData(data);
+   if(font.glyphs == nullptr) {
+      return false;
+   }
+
+   Image atlas = GenImageFontAtlas(font.glyphs, &font.recs, kGlyphCount, kBaseSize, 0, 1);
+   font.texture = LoadTextureFromImage(atlas);
+   m_font = font;
+   save_to_cache(cache_path, source_mod_time, atlas);
+   UnloadImage(atlas);
+   return true;
+}
+
+bool MonoFont::load_from_cache(char const* cache_path, std::optional<long> source_mod_time) {
+   if(!FileExists(cache_path)) {
+      return false;
+   }
+   int size = 0;
+   unsigned char* data = LoadFileData(cache_path, &size);
+   if(data == nullptr) {
+      return false;
+   }
+
+   CacheHeader header;
+   bool valid = static_cast<size_t>(size) >= sizeof(header);
+   if(valid) {
+      std::memcpy(&header, data, sizeof(header));
+      valid = (header.magic == kCacheMagic) && (header.version == kCacheVersion) &&
+              (!source_mod_time.has_value() || (header.source_mod_time == *source_mod_time)) &&
+              (header.base_size == kBaseSize) && (header.glyph_count == kGlyphCount);
+   }
+   if(valid) {
+      // the atlas is read with the header's size and format, so they have to
+      // describe the pixels that are actually there
+      valid = (header.atlas_width > 0) && (header.atlas_width <= kMaxAtlasSide) &&
+              (header.atlas_height > 0) && (header.atlas_height <= kMaxAtlasSide) &&
+              (header.atlas_data_size > 0) &&
+              (GetPixelDataSize(header.atlas_width, header.atlas_height, header.atlas_format) ==
+               header.atlas_data_size);
+   }
+   if(valid) {
+      size_t expected = sizeof(header) + sizeof(CacheGlyph) * header.glyph_count +
+                        static_cast<size_t>(header.atlas_data_size);
+      valid = static_cast<size_t>(size) == expected;
+   }
+   if(!valid) {
+      UnloadFileData(data);
+      return false;
+   }
+
+   Font font{};
+   font.baseSize = header.base_size;
+   font.glyphCount = header.glyph_count;
+   font.glyphPadding = header.glyph_padding;
+   // allocated with MemAlloc so UnloadFont can release them
+   font.glyphs = static_cast<GlyphInfo*>(MemAlloc(sizeof(GlyphInfo) * font.glyphCount));
+   font.recs = static_cast<Rectangle*>(MemAlloc(sizeof(Rectangle) * font.glyphCount));
+
+   unsigned char const* cursor = data + sizeof(header);
+   for(int i = 0; i < font.glyphCount; ++i) {
+      CacheGlyph glyph;
+      std::memcpy(&glyph, cursor, sizeof(glyph));
+      cursor += sizeof(glyph);
+      font.glyphs[i] = GlyphInfo{
+         .value = glyph.value,
+         .offsetX = glyph.offset_x,
+         .offsetY = glyph.offset_y,
+         .advanceX = glyph.advance_x,
+         .image = Image{},
+      };
+      font.recs[i] = glyph.rec;
+   }
+
+   Image atlas{};
+   atlas.data = MemAlloc(header.atlas_data_size);
+   std::memcpy(atlas.data, cursor, header.atlas_data_size);
+   atlas.width = header.atlas_width;
+   atlas.height = header.atlas_height;
+   atlas.mipmaps = 1;
+   atlas.format = header.atlas_format;
+   UnloadFileData(data);
+
+   font.texture = LoadTextureFromImage(atlas);
+   UnloadImage(atlas);
+   m_font = font;
+   return true;
+}
+
+void MonoFont::save_to_cache(
+   char const* cache_path, long source_mod_time, Image const& atlas
+) const {
+   int atlas_size = GetPixelDataSize(atlas.width, atlas.height, atlas.format);
+
+   CacheHeader header{
+      .magic = kCacheMagic,
+      .version = kCacheVersion,
+      .source_mod_time = source_mod_time,
+      .base_size = m_font.baseSize,
+      .glyph_count = m_font.glyphCount,
+      .glyph_padding = m_font.glyphPadding,
+      .atlas_width = atlas.width,
+      .atlas_height = atlas.height,
+      .atlas_format = atlas.format,
+      .atlas_data_size = atlas_size,
+   };
+
+   std::vector<unsigned char> bytes(sizeof(header));
+   std::memcpy(bytes.data(), &header, sizeof(header));
+   for(int i = 0; i < m_font.glyphCount; ++i) {
+      CacheGlyph glyph{
+         .value = m_font.glyphs[i].value,
+         .offset_x = m_font.glyphs[i].offsetX,
+         .offset_y = m_font.glyphs[i].offsetY,
+         .advance_x = m_font.glyphs[i].advanceX,
+         .rec = m_font.recs[i],
+      };
+      auto const* raw = reinterpret_cast<unsigned char const*>(&glyph);
+      bytes.insert(bytes.end(), raw, raw + sizeof(glyph));
+   }
+   auto const* pixels = static_cast<unsigned char const*>(atlas.data);
+   bytes.insert(bytes.end(), pixels, pixels + atlas_size);
+
+   // a failed write only costs the next startup a re-bake
+   (void)SaveFileData(cache_path, bytes.data(), static_cast<int>(bytes.size()));
+}
+
+void MonoFont::begin() const {
+   if(m_is_sdf) {
+      BeginShaderMode(m_shader);
+   }
+}
+
+void MonoFont::end() const {
+   if(m_is_sdf) {
+      EndShaderMode();
+   }
+}
+
+void MonoFont::draw_char(char c, float x, float y, int font_size, Color color) const {
+   if((c == ' ') || (c == '\0')) {
+      return;
+   }
+   DrawTextCodepoint(m_font, c, Vector2{x, y}, static_cast<float>(font_size), color);
+}
+
+void MonoFont::draw(std::string_view text, float x, float y, int font_size, Color color) const {
+   float width = char_width(font_size);
+   begin();
+   for(size_t i = 0; i < text.size(); ++i) {
+      draw_char(text[i], x + static_cast<float>(i) * width, y, font_size, color);
+   }
+   end();
+}
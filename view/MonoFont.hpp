@@ -0,0 +1,64 @@
+#pragma once
+
+#include "raylib.h"
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+/// @brief The monospace UI font, rendered from a signed distance field atlas so
+/// it stays sharp at every size.
+///
+/// The atlas is baked from a TTF through stb_truetype the first time the
+/// program runs and cached on disk next to the executable, so later startups
+/// only read the cached atlas. If the TTF cannot be found the raylib default
+/// font is used instead.
+///
+/// All glyphs have the same advance, so text width is computed from the
+/// character count without walking the string.
+class MonoFont {
+public:
+   static MonoFont& get();
+
+   /// @brief Must be called after the window is created
+   void load();
+   /// @brief Must be called before the window is closed
+   void unload();
+
+   /// @brief Horizontal distance between consecutive characters
+   float char_width(int font_size) const {
+      return m_advance * static_cast<float>(font_size);
+   }
+
+   int measure(size_t n_chars, int font_size) const {
+      return static_cast<int>(static_cast<float>(n_chars) * char_width(font_size));
+   }
+
+   int measure(std::string_view text, int font_size) const {
+      return measure(text.size(), font_size);
+   }
+
+   void draw(std::string_view text, float x, float y, int font_size, Color color) const;
+
+   /// @brief Draw many characters with a single shader switch. draw_char may
+   /// only be called between begin() and end().
+   void begin() const;
+   void draw_char(char c, float x, float y, int font_size, Color color) const;
+   void end() const;
+
+private:
+   MonoFont() = default;
+
+   Font m_font{};
+   Shader m_shader{};
+   bool m_is_sdf = false;
+   bool m_loaded = false;
+   /// @brief advance per unit of font size
+   float m_advance = 0.6f;
+
+   /// @brief Without a source_mod_time, a cache baked from any TTF is used
+   bool load_from_cache(char const* cache_path, std::optional<long> source_mod_time);
+   void save_to_cache(char const* cache_path, long source_mod_time, Image const& atlas) const;
+   bool bake_from_ttf(char const* ttf_path, char const* cache_path, long source_mod_time);
+   void finish_load();
+};
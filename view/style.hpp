@@ -17,6 +17,8 @@ public:
    Color highlight;
    Color syntax_double_color;
    Color syntax_string_color;
+   Color syntax_bytes_color;
+   Color syntax_bitset_color;
 };
 
 inline Color to_dark_text_color(intbase::IntBase base) {
@@ -63,4 +65,6 @@ constexpr Style kDefaultStyle = {
    Color{0x1a, 0x3a, 0xac, 0xff},
    PURPLE,
    DARKBLUE,
+   ORANGE,
+   VIOLET,
 };
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "ui_components.hpp"
+#include "view/MonoFont.hpp"
 
 #include <cmath>
 #include <optional>
@@ -36,7 +37,7 @@ void single_line_textbox(
    int x, int y, int w, std::string const& str, int font_size, Color outline, Color fill, Color text
 ) {
    textbox_background(x, y, w, font_size, outline, fill);
-   DrawText(str.c_str(), x + 2 + font_size / 8, y + 2, font_size, text);
+   MonoFont::get().draw(str, x + 2 + font_size / 8, y + 2, font_size, text);
 }
 
 void rich_text_box(
@@ -44,25 +45,38 @@ void rich_text_box(
    Color text_default, Color highlight, int highlighted_index,
    std::vector<SpanDescription> const& spans
 ) {
+   auto const& font = MonoFont::get();
    textbox_background(x, y, w, font_size, outline, fill);
 
-   int xoffset = x + 2 + font_size / 8;
-   bool first_popup = true;
+   int text_x = x + 2 + font_size / 8;
+   float char_width = font.char_width(font_size);
+
+   font.begin();
+   for(size_t char_i = 0; char_i < str.size(); ++char_i) {
+      font.draw_char(
+         str[char_i],
+         text_x + char_i * char_width,
+         y + 2,
+         font_size,
+         get_color(char_i, spans).value_or(text_default)
+      );
+   }
+   font.end();
 
+   // popups are drawn after all text so the glyphs share one shader pass
+   bool first_popup = true;
    for(size_t char_i = 0; char_i < str.size(); ++char_i) {
-      char cstr[2] = {str[char_i], 0};
-      DrawText(cstr, xoffset, y + 2, font_size, get_color(char_i, spans).value_or(text_default));
       auto popup = get_popup(char_i, spans);
       if(popup.has_value()) {
          static constexpr int kPopupVertPad = 10;
+         int xoffset = text_x + font.measure(char_i, font_size);
 
          if(first_popup) {
-            auto popup_c_str = popup->c_str();
             single_line_textbox(
                xoffset,
                y - kDefaultStyle.small_font - 4 - kPopupVertPad,
-               MeasureText(popup_c_str, kDefaultStyle.small_font) + 6,
-               popup_c_str,
+               font.measure(*popup, kDefaultStyle.small_font) + 6,
+               *popup,
                kDefaultStyle.small_font,
                kDefaultStyle.dark_text,
                kDefaultStyle.dark_bg,
@@ -78,27 +92,24 @@ void rich_text_box(
 
          first_popup = false;
       }
-      xoffset += MeasureText(cstr, font_size) + font_size / 10;
    }
 
    if(highlighted_index != -1) {
-      auto pre_str = str.substr(0, highlighted_index);
-      auto port_str = str.substr(0, highlighted_index + 1);
-      auto start = MeasureText(pre_str.c_str(), font_size);
-      auto end = static_cast<size_t>(highlighted_index) >= str.size()
-                    ? start + 10 // default cursor width
-                    : MeasureText(port_str.c_str(), font_size);
-
-      Color lerpHighlight = highlight;
-      float lerp = (std::sin(GetTime() * 6.28 / kBlinkPeriod) + 1.0) / 2.0;
-      lerpHighlight.a = (int)(lerp * (float)lerpHighlight.a);
-
-      DrawRectangle(
-         x + start + 2 + font_size / 8 + letter_spacing() / 2,
-         y + 2,
-         end - start,
-         font_size,
-         lerpHighlight
-      );
+      text_cursor(x, y, str, font_size, highlight, highlighted_index);
    }
 }
+
+void text_cursor(
+   int x, int y, std::string const& str, int font_size, Color highlight, int highlighted_index
+) {
+   auto const& font = MonoFont::get();
+   // monospace: the cursor covers exactly one character cell
+   auto start = font.measure(static_cast<size_t>(highlighted_index), font_size);
+   auto width = static_cast<int>(font.char_width(font_size));
+
+   Color lerpHighlight = highlight;
+   float lerp = (std::sin(GetTime() * 6.28 / kBlinkPeriod) + 1.0) / 2.0;
+   lerpHighlight.a = (int)(lerp * (float)lerpHighlight.a);
+
+   DrawRectangle(x + start + 2 + font_size / 8, y + 2, width, font_size, lerpHighlight);
+}
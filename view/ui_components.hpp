@@ -3,6 +3,7 @@
 #include "text.hpp"
 #include "raylib.h"
 #include "view/style.hpp"
+#include <string>
 #include <vector>
 
 static constexpr int bigfont_textbox_height() {
@@ -13,10 +14,6 @@ static constexpr int smallfont_textbox_height() {
    return kDefaultStyle.small_font + 4;
 }
 
-static constexpr int letter_spacing() {
-   return kDefaultStyle.big_font / 5;
-}
-
 struct SpanDescription {
    TextSpan span;
    Color color;
@@ -31,8 +28,16 @@ void single_line_textbox(
    int x, int y, int w, std::string const& str, int font_size, Color outline, Color fill, Color text
 );
 
+/// @brief Draws a rich text box. The blinking cursor is drawn at
+/// highlighted_index, or not at all if it is -1.
 void rich_text_box(
    int x, int y, int w, std::string const& str, int font_size, Color outline, Color fill,
    Color text_default, Color highlight, int highlighted_index,
    std::vector<SpanDescription> const& spans
-);
\ No newline at end of file
+);
+
+/// @brief Draws only the blinking cursor of a rich_text_box with the same
+/// position and contents.
+void text_cursor(
+   int x, int y, std::string const& str, int font_size, Color highlight, int highlighted_index
+);
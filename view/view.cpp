@@ -3,19 +3,25 @@
 #include "text.hpp"
 #include "ui_components.hpp"
 #include "view/BitfieldDisplay.hpp"
+#include "perf/alloc_tracker.hpp"
+#include "perf/profiler.hpp"
+#include "view/MonoFont.hpp"
 #include "view/style.hpp"
 #include "view/view.hpp"
+#include <algorithm>
 #include <array>
 #include <charconv>
+#include <format>
 #include <iostream>
 #include <optional>
 #include <string>
 #include <vector>
 
 void View::render_stack() {
+   PROFILE_ZONE("View::render_stack");
    // TODO scroll view
-   DrawText("Stack", 5, 5, kDefaultStyle.small_font, kDefaultStyle.dark_text);
-   for(std::size_t i = 0; i < m_controller.state.speculative_stack.data.size(); ++i) {
+   MonoFont::get().draw("Stack", 5, 5, kDefaultStyle.small_font, kDefaultStyle.dark_text);
+   for(std::size_t i = 0; i < m_controller.state.speculative.stack().data.size(); ++i) {
       auto data = m_controller.GetStackDisplayString(i);
       single_line_textbox(
          1,
@@ -30,28 +36,118 @@ void View::render_stack() {
    }
 }
 
+static constexpr int kHistoryTop = 8 + kDefaultStyle.small_font;
+static constexpr Color kStalePreviewColor = Color{0x5a, 0x5a, 0x5a, 0xff};
+static constexpr Color kEditingOutline = ORANGE;
+
 void View::render_history() {
-   // TODO scroll view
-   DrawText(
+   PROFILE_ZONE("View::render_history");
+   int top = watches_height();
+   MonoFont::get().draw(
       "History",
       GetScreenWidth() - 400 + 4,
-      5,
+      top + 5,
       kDefaultStyle.small_font,
       kDefaultStyle.dark_text
    );
-   for(size_t i = 0; i < m_controller.history.size(); ++i) {
-      auto data = m_controller.history[i].c_str();
+   auto const& history = m_controller.history;
+   auto rows = history_rows();
+   auto const& font = MonoFont::get();
+   int x = GetScreenWidth() - 400 - 1;
+   std::string data;
+   for(size_t i = rows.first; i < rows.last; ++i) {
+      data.assign(history[i]);
       auto is_highlighted = m_controller.history_highlighted_index == i;
+      auto is_editing = m_controller.editing_entry == i;
+      int y = (i - rows.first) * bigfont_textbox_height() + top + kHistoryTop;
       single_line_textbox(
-         GetScreenWidth() - 400 - 1,
-         i * bigfont_textbox_height() + 8 + kDefaultStyle.small_font,
+         x,
+         y,
          400,
          data,
          kDefaultStyle.big_font,
-         kDefaultStyle.highlight,
+         is_editing ? kEditingOutline : kDefaultStyle.highlight,
          kDefaultStyle.dark_bg,
          is_highlighted ? kDefaultStyle.dark_text_emphasis : kDefaultStyle.dark_text
       );
+
+      // previews arrive from the background worker, rows without one yet are
+      // drawn without
+      auto preview = m_controller.history_previews.get(i, history[i]);
+      if(!preview.has_value() || !preview->top.has_value()) {
+         continue;
+      }
+      auto text = "= " + m_controller.FormatValue(*preview->top, m_controller.output_display.mode);
+      int text_x = x + 400 - 4 - font.measure(text, kDefaultStyle.small_font);
+      int text_y = y + (bigfont_textbox_height() - kDefaultStyle.small_font) / 2;
+      font.draw(
+         text,
+         text_x,
+         text_y,
+         kDefaultStyle.small_font,
+         preview->stale ? kStalePreviewColor : kDefaultStyle.dark_text
+      );
+   }
+}
+
+View::RowRange View::history_rows() const {
+   auto const& history = m_controller.history;
+   size_t visible_rows = std::max(
+      0, (GetScreenHeight() - watches_height() - kHistoryTop) / bigfont_textbox_height()
+   );
+   // keep the entry being edited or the highlighted one in view, with
+   // neither the newest entries are shown
+   size_t anchor =
+      m_controller.editing_entry.value_or(m_controller.history_highlighted_index);
+   size_t shown_end = std::min(history.size(), anchor + 1);
+   size_t first = (shown_end > visible_rows) ? shown_end - visible_rows : 0;
+   return RowRange{first, std::min(history.size(), first + visible_rows)};
+}
+
+static constexpr int kWatchesTop = 8 + kDefaultStyle.small_font;
+
+int View::watches_height() const {
+   if(m_controller.watches.empty()) {
+      return 0;
+   }
+   return kWatchesTop + m_controller.watches.size() * smallfont_textbox_height();
+}
+
+void View::render_watches() {
+   PROFILE_ZONE("View::render_watches");
+   auto const& font = MonoFont::get();
+   int x = GetScreenWidth() - 400 - 1;
+   font.draw("Watches", x + 5, 5, kDefaultStyle.small_font, kDefaultStyle.dark_text);
+   int y = kWatchesTop;
+   for(auto const& watch : m_controller.watches) {
+      single_line_textbox(
+         x,
+         y,
+         400,
+         watch.name,
+         kDefaultStyle.small_font,
+         kDefaultStyle.highlight,
+         kDefaultStyle.dark_bg,
+         kDefaultStyle.dark_text_emphasis
+      );
+
+      // results arrive from the background worker, a watch without one yet
+      // shows nothing
+      auto result = m_controller.watch_worker.get(watch.id);
+      if(result.has_value()) {
+         std::string text = "-";
+         Color color = result->stale ? kStalePreviewColor : kDefaultStyle.dark_text;
+         if(result->value.has_value()) {
+            text = m_controller.FormatValue(*result->value, m_controller.output_display.mode);
+         } else if(!result->error.empty()) {
+            text = result->error;
+            color = RED;
+         }
+         int text_x = x + 400 - 4 - font.measure(text, kDefaultStyle.small_font);
+         int text_y = y + (smallfont_textbox_height() - kDefaultStyle.small_font) / 2;
+         font.draw(text, text_x, text_y, kDefaultStyle.small_font, color);
+      }
+      y += smallfont_textbox_height();
    }
 }
 
@@ -74,6 +170,12 @@ static std::vector<SpanDescription> tokens_to_span_desc(std::vector<parse::Token
       case parse::TokenType::kString:
          spans.push_back(SpanDescription(tok.span, kDefaultStyle.syntax_string_color));
          break;
+      case parse::TokenType::kBytes:
+         spans.push_back(SpanDescription(tok.span, kDefaultStyle.syntax_bytes_color));
+         break;
+      case parse::TokenType::kBitset:
+         spans.push_back(SpanDescription(tok.span, kDefaultStyle.syntax_bitset_color));
+         break;
       case parse::TokenType::kWord:
          spans.push_back(
             SpanDescription(tok.span, kDefaultStyle.dark_text_emphasis, tok.additional_popup_text)
@@ -88,32 +190,51 @@ static std::vector<SpanDescription> tokens_to_span_desc(std::vector<parse::Token
    return spans;
 }
 
+static constexpr Color kMainInputHighlight = Color{0xff, 0xff, 0xff, 0x80};
+
+int View::main_input_y() const {
+   static constexpr int kPadding = 5;
+   return GetScreenHeight() - bigfont_textbox_height() - smallfont_textbox_height() - kPadding;
+}
+
 void View::render_main_input() {
-   auto highlight = Color{0xff, 0xff, 0xff, 0x80};
+   PROFILE_ZONE("View::render_main_input");
    static constexpr int kPadding = 5;
-   auto y = GetScreenHeight() - bigfont_textbox_height() - smallfont_textbox_height() - kPadding;
 
+   // the cursor blinks, so it is drawn separately by render_main_input_cursor
    rich_text_box(
       5,
-      y,
+      main_input_y(),
       GetScreenWidth() - kPadding * 2,
       m_controller.current_input.c_str(),
       kDefaultStyle.big_font,
       SKYBLUE,
       kDefaultStyle.dark_bg,
       kDefaultStyle.dark_text,
-      highlight,
-      m_controller.highlighted_index,
+      kMainInputHighlight,
+      -1,
       tokens_to_span_desc(m_controller.parsed)
    );
 }
 
+void View::render_main_input_cursor() {
+   text_cursor(
+      5,
+      main_input_y(),
+      m_controller.current_input,
+      kDefaultStyle.big_font,
+      kMainInputHighlight,
+      m_controller.highlighted_index
+   );
+}
+
 struct ModeWidth {
    EnumeratedMode const* mode;
    int width;
 };
 
 void View::render_state_infobar() {
+   PROFILE_ZONE("View::render_state_infobar");
    static constexpr int kKeybindSize = 20;
    static constexpr int kPadding = 5;
 
@@ -123,10 +244,30 @@ void View::render_state_infobar() {
       {&m_controller.output_display, 50},
       {&m_controller.sep_mode, 80},
       {&m_controller.int_width, 60},
+      {&m_controller.lane_view, 50},
       {&m_controller.fix_mode, 50},
       {&m_controller.fast_entry_mode, 90},
+      {&m_controller.live_history_mode, 70},
    };
 
+   auto const& search = m_controller.history_search;
+   if(search.active) {
+      // the search prompt replaces the modes until the search ends
+      single_line_textbox(
+         0,
+         GetScreenHeight() - smallfont_textbox_height(),
+         GetScreenWidth(),
+         std::format(
+            "({}reverse-i-search)`{}'", search.found ? "" : "failing ", search.query
+         ),
+         kDefaultStyle.small_font,
+         kDefaultStyle.light_bg,
+         kDefaultStyle.light_bg,
+         search.found ? DARKBLUE : RED
+      );
+      return;
+   }
+
    int xoffset = 0;
 
    for(auto const& modewidth : modes) {
@@ -159,6 +300,7 @@ void View::render_state_infobar() {
 }
 
 void View::render_multi_base_displays() {
+   PROFILE_ZONE("View::render_multi_base_displays");
    static constexpr int kWidth = 250;
    static constexpr int kPadding = 5;
    single_line_textbox(
@@ -193,26 +335,218 @@ void View::render_multi_base_displays() {
    );
 }
 
-void View::render() {
-   ClearBackground(kDefaultStyle.neutral_bg);
-   render_main_input();
-   render_state_infobar();
-   render_stack();
-   render_history();
-
-   int top_of_stack = 0;
-   if(!m_controller.state.speculative_stack.data.empty() &&
-      m_controller.state.speculative_stack.data.back().type() == calc::Value::Type::kInt) {
-      top_of_stack = m_controller.state.speculative_stack.data.back().as_int();
+int View::bitfield_height() const {
+   if(m_controller.lane_view.ToLane().has_value()) {
+      return LaneDisplay::height();
    }
+   return BitfieldDisplay::height(m_controller.state.speculative.reg());
+}
 
-   render_multi_base_displays();
+void View::render_bitfield() {
+   PROFILE_ZONE("View::render_bitfield");
+   int64_t top_of_stack = 0;
+   auto const& stack = m_controller.state.speculative.stack().data;
+   if(auto lane = m_controller.lane_view.ToLane()) {
+      m_lanes.render(
+         5,
+         GetScreenHeight() - bitfield_height() - 125,
+         *lane,
+         stack.empty() ? nullptr : &stack.back(),
+         m_controller.output_display.mode
+      );
+      return;
+   }
+   if(!stack.empty() && stack.back().type() == calc::Value::Type::kInt) {
+      top_of_stack = stack.back().as_int();
+   }
+   if(!stack.empty() && stack.back().type() == calc::Value::Type::kBitset) {
+      auto words = stack.back().as_bitset();
+      // up to 64 bits still get a cell each
+      if(words.size() > 1) {
+         m_bitfield.render_runs(
+            5, GetScreenHeight() - bitfield_height() - 125, GetScreenWidth() - 10, words
+         );
+         return;
+      }
+      top_of_stack = words.empty() ? 0 : static_cast<int64_t>(words[0]);
+   }
 
-   auto const& reg = m_controller.current_register;
-   BitfieldDisplay::render(
+   // the speculative layout, so a field being typed shows up before commit
+   auto const& reg = m_controller.state.speculative.reg();
+   m_bitfield.render(
       5,
-      GetScreenHeight() - BitfieldDisplay::height(reg) - 125,
+      GetScreenHeight() - bitfield_height() - 125,
       reg,
       top_of_stack
    );
-}
\ No newline at end of file
+}
+
+template <typename RenderFn>
+static void render_cached(CachedPanel& panel, std::uint64_t key, Rectangle bounds, RenderFn fn) {
+   panel.track(key, bounds);
+   // an empty panel, e.g. the watch list without watches, has no texture
+   if(panel.dirty() && (bounds.width >= 1) && (bounds.height >= 1)) {
+      panel.begin();
+      fn();
+      panel.end();
+   }
+}
+
+void View::invalidate() {
+   m_main_input_panel.invalidate();
+   m_infobar_panel.invalidate();
+   m_stack_panel.invalidate();
+   m_history_panel.invalidate();
+   m_watch_panel.invalidate();
+   m_multi_base_panel.invalidate();
+   m_bitfield_panel.invalidate();
+}
+
+void View::render() {
+   PROFILE_ZONE("View::render");
+   ALLOC_PHASE(alloc_tracker::Phase::kRender);
+   static constexpr int kSideWidth = 402;
+   // popups are drawn above the main input box
+   static constexpr int kPopupHeight = 40;
+
+   auto const& rev = m_controller.revisions;
+   float width = GetScreenWidth();
+   float height = GetScreenHeight();
+
+   render_cached(
+      m_main_input_panel,
+      rev.input,
+      Rectangle{
+         0,
+         static_cast<float>(main_input_y() - kPopupHeight),
+         width,
+         kPopupHeight + bigfont_textbox_height() + 1.0f
+      },
+      [this] { render_main_input(); }
+   );
+   render_cached(
+      m_infobar_panel,
+      combine_revisions(rev.modes, rev.search),
+      Rectangle{0, height - smallfont_textbox_height(), width, smallfont_textbox_height()},
+      [this] { render_state_infobar(); }
+   );
+   render_cached(
+      m_stack_panel,
+      combine_revisions(rev.stack, rev.modes),
+      Rectangle{0, 0, kSideWidth, height},
+      [this] { render_stack(); }
+   );
+   float watches_top = watches_height();
+   m_controller.UpdateWatches();
+   render_cached(
+      m_watch_panel,
+      combine_revisions(rev.watches, rev.modes, m_controller.watch_worker.revision()),
+      Rectangle{width - kSideWidth, 0, kSideWidth, watches_top},
+      [this] { render_watches(); }
+   );
+   auto rows = history_rows();
+   m_controller.RequestHistoryPreviews(rows.first, rows.last);
+   render_cached(
+      m_history_panel,
+      combine_revisions(rev.history, rev.modes, m_controller.history_previews.revision()),
+      Rectangle{width - kSideWidth, watches_top, kSideWidth, height - watches_top},
+      [this] { render_history(); }
+   );
+   render_cached(
+      m_multi_base_panel,
+      combine_revisions(rev.stack, rev.modes),
+      Rectangle{0, height - 120, width, smallfont_textbox_height() + 1.0f},
+      [this] { render_multi_base_displays(); }
+   );
+   auto const& reg = m_controller.state.speculative.reg();
+   auto bitfield_panel_height = bitfield_height();
+   render_cached(
+      m_bitfield_panel,
+      // the modes pick between bits and lanes, and the base of the lanes
+      combine_revisions(rev.stack, rev.reg, reg.revision, rev.modes),
+      Rectangle{
+         0,
+         height - bitfield_panel_height - 125,
+         width,
+         static_cast<float>(bitfield_panel_height)
+      },
+      [this] { render_bitfield(); }
+   );
+
+   ClearBackground(kDefaultStyle.neutral_bg);
+   m_main_input_panel.draw();
+   render_main_input_cursor();
+   m_infobar_panel.draw();
+   m_stack_panel.draw();
+   m_history_panel.draw();
+   m_watch_panel.draw();
+   m_multi_base_panel.draw();
+   m_bitfield_panel.draw();
+
+   if(m_controller.show_profiler_overlay) {
+      render_profiler_overlay();
+   }
+}
+
+void View::render_profiler_overlay() {
+   static constexpr int kGraphFrames = 120;
+   static constexpr int kRefreshFrames = 30;
+   static constexpr float kGraphMaxUs = 33333.0f;
+   static constexpr float kFrameBudgetUs = 16666.0f;
+   static constexpr int kWidth = 400;
+   static constexpr int kGraphHeight = 80;
+   static constexpr int kPadding = 5;
+
+   auto const& profiler = profiler::Profiler::get();
+   // the percentiles walk the whole ring buffer, don't do that every frame
+   if(m_profiler_refresh_countdown <= 0) {
+      m_profiler_stats = profiler.summarize();
+      m_profiler_refresh_countdown = kRefreshFrames;
+   }
+   --m_profiler_refresh_countdown;
+
+   auto const& font = MonoFont::get();
+   int row_height = kDefaultStyle.small_font + 2;
+   int height = kGraphHeight + kPadding * 3 + row_height * (m_profiler_stats.size() + 1);
+   int x = (GetScreenWidth() - kWidth) / 2;
+   int y = kPadding;
+   DrawRectangle(x, y, kWidth, height, Fade(kDefaultStyle.dark_bg, 0.9f));
+   DrawRectangleLines(x, y, kWidth, height, kDefaultStyle.dark_text);
+
+   // frame time graph, one bar per frame, with a line at the 60fps budget
+   auto frame_times = profiler.recent_durations_us("frame", kGraphFrames);
+   int graph_x = x + kPadding;
+   int graph_bottom = y + kPadding + kGraphHeight;
+   float bar_width = static_cast<float>(kWidth - kPadding * 2) / kGraphFrames;
+   for(size_t i = 0; i < frame_times.size(); ++i) {
+      float fraction = static_cast<float>(frame_times[i]) / kGraphMaxUs;
+      float bar_height = std::min(fraction, 1.0f) * kGraphHeight;
+      Color color = frame_times[i] > kFrameBudgetUs ? RED : kDefaultStyle.syntax_double_color;
+      DrawRectangleV(
+         Vector2{graph_x + i * bar_width, graph_bottom - bar_height},
+         Vector2{std::max(bar_width - 1.0f, 1.0f), bar_height},
+         color
+      );
+   }
+   int budget_y = graph_bottom - static_cast<int>(kFrameBudgetUs / kGraphMaxUs * kGraphHeight);
+   DrawLine(graph_x, budget_y, x + kWidth - kPadding, budget_y, kDefaultStyle.dark_text);
+
+   int row_y = graph_bottom + kPadding;
+   font.draw(
+      std::format("{:<28}{:>10}{:>10}", "zone", "p50 us", "p99 us"),
+      graph_x,
+      row_y,
+      kDefaultStyle.small_font,
+      kDefaultStyle.dark_text_emphasis
+   );
+   for(auto const& stats : m_profiler_stats) {
+      row_y += row_height;
+      font.draw(
+         std::format("{:<28}{:>10.1f}{:>10.1f}", stats.name, stats.p50_us, stats.p99_us),
+         graph_x,
+         row_y,
+         kDefaultStyle.small_font,
+         kDefaultStyle.dark_text
+      );
+   }
+}
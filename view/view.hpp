@@ -1,20 +1,60 @@
 #pragma once
 
 #include "controller.hpp"
+#include "perf/profiler.hpp"
+#include "view/BitfieldDisplay.hpp"
+#include "view/CachedPanel.hpp"
+#include "view/LaneDisplay.hpp"
 
 class View {
 public:
    View(Controller& controller) : m_controller(controller) {}
    void render();
+   /// @brief Force every cached panel to be redrawn on the next render
+   void invalidate();
 
 private:
    Controller& m_controller;
 
+   // Each panel is drawn into its own texture and only redrawn when the
+   // controller state it depends on changes.
+   CachedPanel m_main_input_panel;
+   CachedPanel m_infobar_panel;
+   CachedPanel m_stack_panel;
+   CachedPanel m_history_panel;
+   CachedPanel m_watch_panel;
+   CachedPanel m_multi_base_panel;
+   CachedPanel m_bitfield_panel;
+
+   BitfieldDisplay m_bitfield;
+   LaneDisplay m_lanes;
+
+   std::vector<profiler::ZoneStats> m_profiler_stats;
+   int m_profiler_refresh_countdown = 0;
+
+   int main_input_y() const;
+   /// @brief Height of the watch list above the history, zero without watches
+   int watches_height() const;
+   /// @brief Height of the bit display, or of the lanes in the lane view
+   int bitfield_height() const;
+
+   struct RowRange {
+      size_t first;
+      size_t last;
+   };
+   /// @brief History rows that fit in the panel, scrolled so the highlighted
+   /// entry is visible
+   RowRange history_rows() const;
+
    void render_main_input();
+   void render_main_input_cursor();
    void render_state_infobar();
    void render_stack();
    void render_history();
+   void render_watches();
    void render_multi_base_displays();
+   void render_bitfield();
+   void render_profiler_overlay();
 
    void draw_bits(int y, int bitwidth, int64_t value);
 };
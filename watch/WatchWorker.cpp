@@ -0,0 +1,184 @@
+#include "watch/WatchWorker.hpp"
+
+#include "calc/parse.hpp"
+#include "perf/profiler.hpp"
+
+#include <algorithm>
+
+/// @brief Values from the top of the stack a watch first runs against. Most
+/// watches read one or two, so this saves copying a deep stack for each one.
+static constexpr size_t kWindow = 16;
+
+WatchWorker::WatchWorker() : m_thread(&WatchWorker::run, this) {}
+
+WatchWorker::~WatchWorker() {
+   {
+      std::lock_guard lock(m_mutex);
+      m_stop = true;
+   }
+   m_wake.notify_one();
+   m_thread.join();
+}
+
+void WatchWorker::add(Watch watch) {
+   {
+      std::lock_guard lock(m_mutex);
+      uint64_t id = watch.id;
+      m_entries.insert_or_assign(id, Entry{.watch = std::move(watch), .result = WatchResult{}});
+      queue(id);
+      m_revision.fetch_add(1, std::memory_order_release);
+   }
+   m_wake.notify_one();
+}
+
+void WatchWorker::remove(uint64_t id) {
+   std::lock_guard lock(m_mutex);
+   m_entries.erase(id);
+   std::erase(m_pending, id);
+   m_revision.fetch_add(1, std::memory_order_release);
+}
+
+void WatchWorker::set_context(calc::Context context, intbase::IntBase base) {
+   bool queued = false;
+   {
+      std::lock_guard lock(m_mutex);
+      for(auto& [id, entry] : m_entries) {
+         // stale entries are already queued or being evaluated
+         if(!entry.evaluated || entry.result.stale) {
+            continue;
+         }
+         if((base != m_input.base) || !still_valid(entry, m_input.context, context)) {
+            entry.result.stale = true;
+            queue(id);
+            queued = true;
+         }
+      }
+      m_input = Input{m_input.version + 1, std::move(context), base};
+      m_revision.fetch_add(1, std::memory_order_release);
+   }
+   if(queued) {
+      m_wake.notify_one();
+   }
+}
+
+std::optional<WatchResult> WatchWorker::get(uint64_t id) const {
+   std::lock_guard lock(m_mutex);
+   auto it = m_entries.find(id);
+   if((it == m_entries.end()) || !it->second.evaluated) {
+      return std::nullopt;
+   }
+   return it->second.result;
+}
+
+void WatchWorker::queue(uint64_t id) {
+   if(std::find(m_pending.begin(), m_pending.end(), id) == m_pending.end()) {
+      m_pending.push_back(id);
+   }
+}
+
+bool WatchWorker::still_valid(
+   Entry const& entry, calc::Context const& old, calc::Context const& now
+) {
+   if(old.int_width() != now.int_width()) {
+      return false;
+   }
+   if(entry.reads_variables && (old.shared_variables() != now.shared_variables()) &&
+      (old.variables() != now.variables())) {
+      return false;
+   }
+   auto const& old_data = old.stack().data;
+   auto const& now_data = now.stack().data;
+   if(entry.reads_all) {
+      return old_data == now_data;
+   }
+   if(now_data.size() < entry.reads) {
+      return false;
+   }
+   return std::equal(old_data.end() - entry.reads, old_data.end(), now_data.end() - entry.reads);
+}
+
+WatchWorker::Evaluation WatchWorker::evaluate(std::string const& expression, Input const& input) {
+   PROFILE_ZONE("WatchWorker::evaluate");
+   size_t size = input.context.stack().data.size();
+   auto evaluation = evaluate_on(expression, input, std::min(size, kWindow));
+   // it reached the bottom of the window, so it may need the rest
+   if(evaluation.reads_all && (size > kWindow)) {
+      evaluation = evaluate_on(expression, input, size);
+   }
+   return evaluation;
+}
+
+WatchWorker::Evaluation WatchWorker::evaluate_on(
+   std::string const& expression, Input const& input, size_t window
+) {
+   auto const& data = input.context.stack().data;
+   m_state.committed = input.context;
+   m_state.committed.set_stack(calc::Stack{{data.end() - window, data.end()}});
+   auto tokens = parse::parse(parse::ParserSettings(input.base, m_state.functions), expression);
+   m_state.Execute(tokens, true);
+
+   Evaluation evaluation{
+      .result = WatchResult{},
+      .reads = window - std::min(m_state.speculative_low_water, window),
+      .reads_all = m_state.speculative_low_water == 0,
+      .reads_variables = m_state.speculative_read_variables,
+   };
+   auto const& stack = m_state.speculative.stack().data;
+   if(!m_state.speculate_poisoned) {
+      if(!stack.empty()) {
+         evaluation.result.value = stack.back();
+      }
+      return evaluation;
+   }
+   for(auto const& token : tokens) {
+      if(token.type == parse::TokenType::kError) {
+         evaluation.result.error = token.text;
+         break;
+      }
+      if(!token.additional_popup_text.empty()) {
+         // a word that only runs on commit
+         evaluation.result.error = token.additional_popup_text;
+         break;
+      }
+   }
+   return evaluation;
+}
+
+void WatchWorker::run() {
+   std::unique_lock lock(m_mutex);
+   while(true) {
+      m_wake.wait(lock, [this] { return m_stop || !m_pending.empty(); });
+      if(m_stop) {
+         return;
+      }
+      uint64_t id = m_pending.front();
+      m_pending.pop_front();
+      auto it = m_entries.find(id);
+      if(it == m_entries.end()) {
+         continue;
+      }
+      auto expression = it->second.watch.expression;
+      auto input = m_input;
+      lock.unlock();
+
+      auto evaluation = evaluate(expression, input);
+
+      lock.lock();
+      it = m_entries.find(id);
+      if(it == m_entries.end()) {
+         continue;
+      }
+      if(input.version != m_input.version) {
+         // the stack moved on while it was evaluated
+         queue(id);
+         continue;
+      }
+      auto& entry = it->second;
+      entry.result = std::move(evaluation.result);
+      entry.evaluated = true;
+      entry.reads = evaluation.reads;
+      entry.reads_all = evaluation.reads_all;
+      entry.reads_variables = evaluation.reads_variables;
+      m_revision.fetch_add(1, std::memory_order_release);
+   }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "calc/calc.hpp"
+#include "calc/intbase.hpp"
+#include "calc/value.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+/// @brief An expression that is evaluated against the speculative state as the
+/// input changes, e.g. `"q15 32768.0 /` shows the top of the stack as a Q15
+/// fraction
+struct Watch {
+   uint64_t id;
+   std::string name;
+   std::string expression;
+};
+
+struct WatchResult {
+   /// @brief Top of the stack after the expression, empty on failure
+   std::optional<calc::Value> value;
+   /// @brief Why the expression failed, empty if it did not
+   std::string error;
+   /// @brief Evaluated against an older stack and not yet redone
+   bool stale = false;
+};
+
+/// @brief Evaluates watches on a background thread.
+///
+/// Works like PreviewWorker: the UI hands over the state whenever it changes
+/// and the worker evaluates watches against its own copy with its own
+/// calc::State, publishing results one at a time without holding the lock
+/// while executing.
+///
+/// Every result records how many values from the top of the stack it read.
+/// When the state changes, only watches whose values or loaded variables
+/// changed are queued again, so typing below a watch's inputs does not rerun
+/// it.
+class WatchWorker {
+public:
+   WatchWorker();
+   ~WatchWorker();
+   WatchWorker(WatchWorker const&) = delete;
+   WatchWorker& operator=(WatchWorker const&) = delete;
+
+   void add(Watch watch);
+   void remove(uint64_t id);
+
+   /// @brief Replace the state and parse settings that watches run against
+   void set_context(calc::Context context, intbase::IntBase base);
+
+   /// @brief The latest result for a watch if it has been evaluated
+   std::optional<WatchResult> get(uint64_t id) const;
+
+   /// @brief Bumped whenever a result is published or becomes stale
+   uint64_t revision() const {
+      return m_revision.load(std::memory_order_acquire);
+   }
+
+private:
+   struct Input {
+      /// @brief Bumped by every set_context, results from an older input are
+      /// dropped
+      uint64_t version = 0;
+      /// @brief Shares its parts, so the worker takes it without copying them
+      /// under the lock
+      calc::Context context;
+      intbase::IntBase base = intbase::IntBase::kDec;
+   };
+
+   struct Entry {
+      Watch watch;
+      WatchResult result;
+      bool evaluated = false;
+      /// @brief Number of values from the top of the stack the result read
+      size_t reads = 0;
+      /// @brief The result also depends on the stack size
+      bool reads_all = false;
+      bool reads_variables = false;
+   };
+
+   struct Evaluation {
+      WatchResult result;
+      size_t reads;
+      bool reads_all;
+      bool reads_variables;
+   };
+
+   mutable std::mutex m_mutex;
+   std::condition_variable m_wake;
+   bool m_stop = false;
+   Input m_input;
+   std::unordered_map<uint64_t, Entry> m_entries;
+   std::deque<uint64_t> m_pending;
+   std::atomic<uint64_t> m_revision{0};
+
+   // only touched by the worker thread
+   calc::State m_state;
+
+   std::thread m_thread;
+
+   void run();
+   void queue(uint64_t id);
+   Evaluation evaluate(std::string const& expression, Input const& input);
+   Evaluation evaluate_on(std::string const& expression, Input const& input, size_t window);
+   static bool
+   still_valid(Entry const& entry, calc::Context const& old, calc::Context const& now);
+};